@@ -1,12 +1,18 @@
-// Game mode for the boat game - controls the game wave manager
+// Game mode for the boat game - controls the game wave manager, foam manager, float system, significance manager, spatial hash and ocean context
 
 #include "CustomMeshTest.h"
 #include "WaveManager.h"
 #include "GerstnerWaveForm.h"
+#include "FoamManager.h"
+#include "FloatSystem.h"
+#include "OceanSignificanceManager.h"
+#include "OceanSpatialHash.h"
 #include "Boat.h"
 #include "BoatController.h"
 #include "CustomMeshTestGameMode.h"
 
+TWeakObjectPtr<ACustomMeshTestGameMode> ACustomMeshTestGameMode::FoundGameMode;
+
 // Sets default values for this actor's properties
 ACustomMeshTestGameMode::ACustomMeshTestGameMode(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
@@ -19,6 +25,17 @@ ACustomMeshTestGameMode::ACustomMeshTestGameMode(const FObjectInitializer& Objec
 	PlayerControllerClass = ABoatController::StaticClass();
 }
 
+// Spawn the world ocean systems before any actor begins play, so the ocean context always has them
+void ACustomMeshTestGameMode::StartPlay()
+{
+	GetSignificanceManager();
+	GetSpatialHash();
+	GetFloatSystem();
+	GetFoamManager();
+
+	Super::StartPlay();
+}
+
 // Create the game wave manager
 void ACustomMeshTestGameMode::CreateWaveManager()
 {
@@ -31,3 +48,88 @@ UWaveManager* ACustomMeshTestGameMode::GetWaveManager()
 	return WaveManager;
 }
 
+// Global access point for getting game foam manager, spawning it the first time it is needed
+AFoamManager* ACustomMeshTestGameMode::GetFoamManager()
+{
+	if (!FoamManager && GetWorld())
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.Owner = this;
+		FoamManager = GetWorld()->SpawnActor<AFoamManager>(FVector::ZeroVector, FRotator::ZeroRotator, SpawnParams);
+	}
+	return FoamManager;
+}
+
+// Global access point for getting game float system, spawning it the first time it is needed
+AFloatSystem* ACustomMeshTestGameMode::GetFloatSystem()
+{
+	if (!FloatSystem && GetWorld())
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.Owner = this;
+		FloatSystem = GetWorld()->SpawnActor<AFloatSystem>(FVector::ZeroVector, FRotator::ZeroRotator, SpawnParams);
+	}
+	return FloatSystem;
+}
+
+// Global access point for getting game ocean significance manager, spawning it the first time it is needed
+AOceanSignificanceManager* ACustomMeshTestGameMode::GetSignificanceManager()
+{
+	if (!SignificanceManager && GetWorld())
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.Owner = this;
+		SignificanceManager = GetWorld()->SpawnActor<AOceanSignificanceManager>(FVector::ZeroVector, FRotator::ZeroRotator, SpawnParams);
+	}
+	return SignificanceManager;
+}
+
+// Global access point for getting game ocean spatial hash, spawning it the first time it is needed
+AOceanSpatialHash* ACustomMeshTestGameMode::GetSpatialHash()
+{
+	if (!SpatialHash && GetWorld())
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.Owner = this;
+		SpatialHash = GetWorld()->SpawnActor<AOceanSpatialHash>(FVector::ZeroVector, FRotator::ZeroRotator, SpawnParams);
+	}
+	return SpatialHash;
+}
+
+// Global access point for getting this frame's ocean context, publishing it the first time it is needed in a frame
+const FOceanContext& ACustomMeshTestGameMode::GetOceanContext()
+{
+	if (OceanContext.FrameNumber != GFrameCounter)
+	{
+		OceanContext.FrameNumber = GFrameCounter;
+		OceanContext.WaveManager = WaveManager;
+		OceanContext.WaveVersion = WaveManager ? WaveManager->GetWaveVersion() : 0;
+		OceanContext.Time = GetWorld() ? GetWorld()->GetTimeSeconds() : 0.f;
+		OceanContext.Wind = Wind;
+		OceanContext.PlayerPawn = UGameplayStatics::GetPlayerPawn(this, 0);
+		OceanContext.PlayerLocation = OceanContext.PlayerPawn ? OceanContext.PlayerPawn->GetActorLocation() : FVector::ZeroVector;
+
+		//systems as they are, publishing the context never spawns them
+		OceanContext.FoamManager = FoamManager;
+		OceanContext.FloatSystem = FloatSystem;
+		OceanContext.SignificanceManager = SignificanceManager;
+		OceanContext.SpatialHash = SpatialHash;
+	}
+	return OceanContext;
+}
+
+// Ocean context of the world an object is in, null if the world isn't running this game mode
+const FOceanContext* ACustomMeshTestGameMode::FindOceanContext(const UObject* WorldContextObject)
+{
+	UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	if (!World) return nullptr;
+
+	//only cast the world's game mode when it isn't the one found last time
+	ACustomMeshTestGameMode* CustomGameMode = FoundGameMode.Get();
+	if (!CustomGameMode || CustomGameMode->GetWorld() != World)
+	{
+		CustomGameMode = Cast<ACustomMeshTestGameMode>(World->GetAuthGameMode());
+		FoundGameMode = CustomGameMode;
+	}
+	return CustomGameMode ? &CustomGameMode->GetOceanContext() : nullptr;
+}
@@ -1,10 +1,43 @@
-// Game mode for the boat game - controls the game wave manager
+// Game mode for the boat game - controls the game wave manager, foam manager, float system, significance manager, spatial hash and ocean context
 
 #pragma once
 
 #include "GameFramework/GameMode.h"
 #include "CustomMeshTestGameMode.generated.h"
 
+//read-only ocean state published once per frame, so every ocean system sees the same waves, time, wind and player
+struct FOceanContext
+{
+	//game wave manager and its wave version when the frame started
+	class UWaveManager* WaveManager;
+	int32 WaveVersion;
+
+	//simulation time every ocean system uses this frame
+	float Time;
+
+	//game wind vector
+	FVector Wind;
+
+	//player pawn and its location, pawn is null when there is no player
+	class APawn* PlayerPawn;
+	FVector PlayerLocation;
+
+	//game foam manager, float system, significance manager and spatial hash, spawned when play starts
+	class AFoamManager* FoamManager;
+	class AFloatSystem* FloatSystem;
+	class AOceanSignificanceManager* SignificanceManager;
+	class AOceanSpatialHash* SpatialHash;
+
+	//frame this context was published for
+	uint64 FrameNumber;
+
+	FOceanContext()
+		: WaveManager(nullptr), WaveVersion(0), Time(0.f), Wind(FVector::ZeroVector), PlayerPawn(nullptr), PlayerLocation(FVector::ZeroVector),
+		FoamManager(nullptr), FloatSystem(nullptr), SignificanceManager(nullptr), SpatialHash(nullptr), FrameNumber(MAX_uint64)
+	{
+	}
+};
+
 /**
  * 
  */
@@ -19,12 +52,37 @@ private:
 	UPROPERTY()
 	class UWaveManager* WaveManager;
 
+	//game foam manager
+	UPROPERTY()
+	class AFoamManager* FoamManager;
+
+	//game float system
+	UPROPERTY()
+	class AFloatSystem* FloatSystem;
+
+	//game ocean significance manager
+	UPROPERTY()
+	class AOceanSignificanceManager* SignificanceManager;
+
+	//game ocean spatial hash
+	UPROPERTY()
+	class AOceanSpatialHash* SpatialHash;
+
+	//ocean context for the current frame
+	FOceanContext OceanContext;
+
+	//game mode the last ocean context was found on, only looked up again when the world changes
+	static TWeakObjectPtr<ACustomMeshTestGameMode> FoundGameMode;
+
 public:
 
 
 	// Sets default values for this actor's properties
 	ACustomMeshTestGameMode(const FObjectInitializer& ObjectInitializer);
 
+	// Spawn the world ocean systems before any actor begins play, so the ocean context always has them
+	virtual void StartPlay() override;
+
 	// Create the game wave manager
 	UFUNCTION(BlueprintCallable, Category = WaveManagement)
 	void CreateWaveManager();
@@ -32,6 +90,28 @@ public:
 	// Global access point for getting game wave manager
 	UFUNCTION(BlueprintCallable, Category = WaveManagement)
 	class UWaveManager* GetWaveManager();
+
+	// Global access point for getting game foam manager, spawning it the first time it is needed
+	UFUNCTION(BlueprintCallable, Category = FoamManagement)
+	class AFoamManager* GetFoamManager();
+
+	// Global access point for getting game float system, spawning it the first time it is needed
+	UFUNCTION(BlueprintCallable, Category = FloatManagement)
+	class AFloatSystem* GetFloatSystem();
+
+	// Global access point for getting game ocean significance manager, spawning it the first time it is needed
+	UFUNCTION(BlueprintCallable, Category = Significance)
+	class AOceanSignificanceManager* GetSignificanceManager();
+
+	// Global access point for getting game ocean spatial hash, spawning it the first time it is needed
+	UFUNCTION(BlueprintCallable, Category = SpatialQuery)
+	class AOceanSpatialHash* GetSpatialHash();
+
+	// Global access point for getting this frame's ocean context, publishing it the first time it is needed in a frame
+	const FOceanContext& GetOceanContext();
+
+	// Ocean context of the world an object is in, null if the world isn't running this game mode
+	static const FOceanContext* FindOceanContext(const UObject* WorldContextObject);
 	
 	// Game wind vector
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Wind)
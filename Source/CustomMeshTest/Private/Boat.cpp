@@ -4,9 +4,12 @@
 #include "WaveManager.h"
 #include "CustomMeshTestGameMode.h"
 #include "BoatAnimInstance.h"
-#include "FoamDecal.h"
+#include "FoamManager.h"
 #include "Classes/Components/SplineComponent.h"
 #include "FloatComponent.h"
+#include "WakeRibbonComponent.h"
+#include "SprayEmitterComponent.h"
+#include "OceanSpatialHash.h"
 #include "Boat.h"
 
 
@@ -24,6 +27,7 @@ ABoat::ABoat()
 	static ConstructorHelpers::FClassFinder<UAnimInstance> BoatAnimClassFinder(TEXT("/Game/Boat/Animations/TestBoatAnimBP"));
 	BoatMesh->SetSkeletalMesh(BoatMeshClassFinder.Object);
 	BoatMesh->SetAnimInstanceClass(BoatAnimClassFinder.Class);
+	BoatMesh->MeshComponentUpdateFlag = EMeshComponentUpdateFlag::OnlyTickPoseWhenRendered;
 
 	//lens light beam mesh
 	LightBeamMesh = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("LightBeamMesh"));
@@ -37,6 +41,10 @@ ABoat::ABoat()
 	//float physics
 	FloatComp = CreateDefaultSubobject<UFloatComponent>(TEXT("FloatComp"));
 	FloatComp->SideDrag = 0.8f;
+	FloatComp->SpatialKind = EOceanSpatialKind::OSK_Vessel;
+	FloatComp->ContactRadius = 80.f;
+	FloatComp->ContactHalfLength = 120.f;
+	FloatComp->ContactMass = 1000.f;
 
 	//foam particle system
 	FoamSpray = CreateDefaultSubobject<UParticleSystemComponent>(TEXT("FoamSpray"));
@@ -49,6 +57,14 @@ ABoat::ABoat()
 	FoamSpline = CreateDefaultSubobject<USplineComponent>(TEXT("FoamSpline"));
 	FoamSpline->AttachToComponent(RootComponent, AttachRules);
 
+	//wake ribbon left behind the boat
+	WakeRibbon = CreateDefaultSubobject<UWakeRibbonComponent>(TEXT("WakeRibbon"));
+	WakeRibbon->AttachToComponent(RootComponent, AttachRules);
+
+	//native spray thrown up from the foam spline
+	SprayEmitter = CreateDefaultSubobject<USprayEmitterComponent>(TEXT("SprayEmitter"));
+	SprayEmitter->AttachToComponent(RootComponent, AttachRules);
+
 	//camera view
 	CameraComp = CreateDefaultSubobject<UCameraComponent>(TEXT("Camera"));
 	CameraComp->AttachToComponent(RootComponent, AttachRules);
@@ -86,19 +102,31 @@ ABoat::ABoat()
 	LensYawMax = 90.f;
 	LensPitchMax = 80.f;
 	LensPitchMin = -20.f;
+	LensBeamRange = 5000.f;
+	LensBeamTargetReach = 400.f;
+	LensBeamHitActor = nullptr;
+	SpatialHash = nullptr;
 
 	//oar params
 	OarPowerMax = 50;
 	OarResist = 0.65f;
 
 	//foam particle params
+	bWakeRibbon = false;
 	FoamInterval = 400.f;
 	FoamPassiveAdd = 80.f;
 	FoamOffset = 1.f;
+	bNativeSpray = false;
 	SprayAmount = 0.2f;
 	SprayMaxSpeed = 5.f;
 	SprayMinSpeed = 2.f;
 
+	//foam map splat params
+	FoamMapBowRadius = 150.f;
+	FoamMapBowRate = 2.f;
+	FoamMapHullRadius = 250.f;
+	FoamMapDragRate = 1.f;
+
 	//foam spline points
 	SprayCurvePoints.Add(FVector(-90.f, -50.f, 10.f));
 	SprayCurvePoints.Add(FVector(70.f, -50.f, 10.f));
@@ -110,6 +138,9 @@ ABoat::ABoat()
 	CameraOffset = FVector(0.f, 0.f, 30.f);
 	CameraDistance = 600.f;
 	CameraTilt = 7.5f;
+	bAsyncCameraTrace = true;
+	CameraWaterClearance = 5.f;
+	CameraArmFraction = 1.f;
 }
 
 // Called when the game starts or when spawned
@@ -136,6 +167,13 @@ void ABoat::BeginPlay()
 	//create foam spline
 	FoamSpline->SetSplineLocalPoints(SprayCurvePoints);
 
+	//spray emits from a table of the spline rather than walking the spline per particle
+	SprayEmitter->BuildArcTable(FoamSpline);
+
+	//get game spatial hash for lens beam targets
+	const FOceanContext* Ocean = ACustomMeshTestGameMode::FindOceanContext(this);
+	SpatialHash = Ocean ? Ocean->SpatialHash : nullptr;
+
 }
 
 // Called every frame
@@ -148,6 +186,13 @@ void ABoat::Tick( float DeltaTime )
 	HandleMovement(DeltaTime);
 	HandleFoam(DeltaTime);
 	HandleCamera(DeltaTime);
+	HandleLensBeam(DeltaTime);
+
+	//don't evaluate a pose that hasn't moved
+	if (BoatAnim)
+	{
+		BoatMesh->bNoSkeletonUpdate = !BoatAnim->NeedsPoseUpdate(DeltaTime);
+	}
 }
 
 // Function with falloff, so that light winds give relatively more power than strong winds - to ensure the boat can get going.
@@ -287,6 +332,14 @@ void ABoat::SetLensFire(bool Fire)
 	LightBeamMesh->SetVisibility(Fire);
 }
 
+// Where the lens beam ends and the buoy or vessel it is on, null if it isn't on one - returns false if the lens isn't firing
+bool ABoat::GetLensBeamHit(AActor* &HitActor, FVector &HitLocation)
+{
+	HitActor = LensBeamHitActor;
+	HitLocation = LensBeamEnd;
+	return LensFire;
+}
+
 // Below get functions are for getting touch zone locations and swipe rotations
 
 FVector ABoat::GetRudderWorldLocation()
@@ -359,6 +412,71 @@ FRotator ABoat::GetLensPitchWorldRotation()
 	return GetActorRotation() + LensPitchSwipeRot;
 }
 
+// Handle lens beam hits
+void ABoat::HandleLensBeam(float DeltaTime)
+{
+	LensBeamHitActor = nullptr;
+	if (!LensFire) return;
+
+	//aimed by the lens yaw and pitch rather than the socket, so it's right even on frames the pose isn't updated
+	FVector Start = BoatMesh->GetSocketLocation("lensFire");
+	FVector Direction = GetActorQuat().RotateVector(FRotator(LensPitch, LensYaw, 0.f).Vector());
+	LensBeamEnd = Start + Direction * LensBeamRange;
+
+	const FOceanContext* Ocean = ACustomMeshTestGameMode::FindOceanContext(this);
+	if (Ocean && Ocean->WaveManager)
+	{
+		//the beam can't pass under the lowest possible trough without meeting the waves, so the wave trace stops there
+		float Trough = -Ocean->WaveManager->GetMaxWaveHeight();
+		if (Start.Z > Trough && LensBeamEnd.Z < Trough)
+		{
+			LensBeamEnd = FMath::LinePlaneIntersection(Start, LensBeamEnd, FVector(0.f, 0.f, Trough), FVector::UpVector);
+		}
+
+		FVector WaveHit;
+		FVector WaveNormal;
+		if (Ocean->WaveManager->LineTraceWaves(Start, LensBeamEnd, Ocean->Time, WaveHit, WaveNormal))
+		{
+			LensBeamEnd = WaveHit;
+		}
+	}
+
+	if (!SpatialHash) return;
+
+	//only buoys and vessels near the beam, in order along it, up to where it meets the waves
+	int32 KindMask = AOceanSpatialHash::GetKindMask(EOceanSpatialKind::OSK_Float) | AOceanSpatialHash::GetKindMask(EOceanSpatialKind::OSK_Vessel);
+	SpatialHash->QuerySegment(Start, LensBeamEnd, LensBeamTargetReach, KindMask, LensBeamTargets);
+
+	float BeamLength = (LensBeamEnd - Start).Size();
+	for (int32 i = 0; i < LensBeamTargets.Num(); i++)
+	{
+		AActor* Target = LensBeamTargets[i];
+		if (Target == this) continue;
+
+		//nothing from here on reaches back to the nearest hit so far
+		if (((Target->GetActorLocation() - Start) | Direction) - LensBeamTargetReach > BeamLength) break;
+
+		UPrimitiveComponent* TargetRoot = Cast<UPrimitiveComponent>(Target->GetRootComponent());
+		if (!TargetRoot) continue;
+
+		//cheap bounds check before tracing the target's collision
+		if (FMath::PointDistToSegment(TargetRoot->Bounds.Origin, Start, LensBeamEnd) > TargetRoot->Bounds.SphereRadius) continue;
+
+		FHitResult Hit;
+		if (TargetRoot->LineTraceComponent(Hit, Start, LensBeamEnd, FCollisionQueryParams(NAME_None, false, this)))
+		{
+			LensBeamEnd = Hit.Location;
+			BeamLength = (LensBeamEnd - Start).Size();
+			LensBeamHitActor = Target;
+		}
+	}
+
+	if (LensBeamHitActor)
+	{
+		OnLensBeamHit.Broadcast(LensBeamHitActor, LensBeamEnd, DeltaTime);
+	}
+}
+
 // Handle animated movement of boat parts
 void ABoat::HandlePartsMovement(float DeltaTime)
 {
@@ -423,24 +541,43 @@ void ABoat::HandlePartsMovement(float DeltaTime)
 // Handle foam particle systems
 void ABoat::HandleFoam(float DeltaTime)
 {
+	//wake ribbon replaces the trail of foam decals, broken while flying
+	if (WakeRibbon->IsWakeEnabled() != bWakeRibbon)
+	{
+		WakeRibbon->SetWakeEnabled(bWakeRibbon);
+	}
+	WakeRibbon->bEmitting = bWakeRibbon && !FloatComp->GetIsInAir();
+
 	//no foam when flying
 	if (FloatComp->GetIsInAir()) return; 
 
-	//decals
+	//get game foam manager for this frame
+	const FOceanContext* Ocean = ACustomMeshTestGameMode::FindOceanContext(this);
+	FoamManager = Ocean ? Ocean->FoamManager : nullptr;
 
 	//calc forward speed to determine when next foam needs to spawn
 	float NewMovement = FloatComp->GetVelocity() | GetActorForwardVector();
 
-	FoamIntervalTimer += (NewMovement+FoamPassiveAdd)*DeltaTime;
+	//foam map - bow wave by forward speed, hull wash by drag
+
+	if (FoamManager)
+	{
+		FVector BowLocation = FoamSpline->GetLocationAtSplinePoint(FoamSpline->GetNumberOfSplinePoints() / 2, ESplineCoordinateSpace::World);
+		FoamManager->SplatFoamMap(BowLocation, FoamMapBowRadius, FoamMapBowRate*FMath::Clamp(NewMovement / 100.f, 0.f, 1.f)*DeltaTime);
+		FoamManager->SplatFoamMap(GetActorLocation(), FoamMapHullRadius, FoamMapDragRate*FloatComp->GetCurrentDrag()*DeltaTime);
+	}
+
+	//decals - only when there is no wake ribbon
+
+	if (!bWakeRibbon)
+	{
+		FoamIntervalTimer += (NewMovement+FoamPassiveAdd)*DeltaTime;
+	}
 
 	if (FoamIntervalTimer > FoamInterval)
 	{
 		FoamIntervalTimer -= FoamInterval;
 
-		FActorSpawnParameters SpawnParams;
-		SpawnParams.Owner = this;
-		SpawnParams.Instigator = Instigator;
-
 		FVector FoamSpawnPoint = GetActorLocation();
 		//spawn in front by velocity so that when foam fades in it appears correctly
 		FoamSpawnPoint += GetActorForwardVector()*FoamOffset*FloatComp->GetVelocity().Size();
@@ -450,22 +587,32 @@ void ABoat::HandleFoam(float DeltaTime)
 		FoamSpawnPoint.Z = 5.f;
 
 		//spawn and set parameters based on boat forward speed
-		AFoamDecal* NewFoam = GetWorld()->SpawnActor<AFoamDecal>(FoamSpawnPoint, FRotator::ZeroRotator, SpawnParams);
-		NewFoam->Alpha = FMath::Clamp((NewMovement + FoamPassiveAdd) / 100.f, 0.f, 1.f);
-		NewFoam->GrowRate = (NewMovement + FoamPassiveAdd) / 1000.f;
-		NewFoam->RotateRate = FMath::RandRange(-20.f, 20.f);
+		if (FoamManager)
+		{
+			FoamManager->SpawnFoam(FoamSpawnPoint, FMath::Clamp((NewMovement + FoamPassiveAdd) / 100.f, 0.f, 1.f), (NewMovement + FoamPassiveAdd) / 1000.f, FMath::RandRange(-20.f, 20.f), this);
+		}
 
 	}
 
 	//particles
 
+	//native spray only runs while it is used
+	if (SprayEmitter->IsSprayEnabled() != bNativeSpray)
+	{
+		SprayEmitter->SetSprayEnabled(bNativeSpray);
+	}
+
 	//amount of foam spray based on boat drag
 	SprayTimer += FloatComp->GetCurrentDrag() * DeltaTime * SprayAmount;
 
 	int32 SprayCount = FMath::FloorToInt(SprayTimer);
 	SprayTimer -= SprayCount;
 
-	if (SprayCount > 0)
+	if (SprayCount > 0 && bNativeSpray)
+	{
+		SprayEmitter->Emit(SprayCount, SprayMinSpeed * (FloatComp->GetCurrentDrag() * SprayAmount), SprayMaxSpeed * (FloatComp->GetCurrentDrag() * SprayAmount));
+	}
+	else if (SprayCount > 0)
 	{
 		for (int32 i = 0; i < SprayCount; i++)
 		{
@@ -504,51 +651,76 @@ void ABoat::HandleCamera(float DeltaTime)
 	ObjectTraceParams.AddObjectTypesToQuery(ECollisionChannel::ECC_WorldStatic);
 	ObjectTraceParams.AddObjectTypesToQuery(ECollisionChannel::ECC_WorldDynamic);
 
-	FHitResult TraceHit;
-	if (GetWorld()->LineTraceSingleByObjectType(TraceHit, CameraPos, CameraPos + CameraArm, ObjectTraceParams, TraceParams))
+	FVector CameraArmEnd = CameraPos + CameraArm;
+
+	if (bAsyncCameraTrace)
 	{
-		//if trace hit, place camera at hit location
-		CameraPos = TraceHit.Location;
+		//use the trace started last frame, as a fraction of this frame's arm - the arm barely moves in a frame
+		FTraceDatum CameraTraceData;
+		if (CameraTraceHandle.IsValid() && GetWorld()->QueryTraceData(CameraTraceHandle, CameraTraceData))
+		{
+			CameraArmFraction = (CameraTraceData.OutHits.Num() > 0 && CameraTraceData.OutHits[0].bBlockingHit) ? CameraTraceData.OutHits[0].Time : 1.f;
+		}
+		CameraArmEnd = CameraPos + CameraArm * CameraArmFraction;
+
+		//start next frame's trace now so it runs alongside the rest of the frame instead of blocking the game thread
+		CameraTraceHandle = GetWorld()->AsyncLineTraceByObjectType(EAsyncTraceType::Single, CameraPos, CameraPos + CameraArm, ObjectTraceParams, TraceParams);
 	}
 	else
 	{
-		//place camera at end of camera arm
-		CameraPos += CameraArm;
+		FHitResult TraceHit;
+		if (GetWorld()->LineTraceSingleByObjectType(TraceHit, CameraPos, CameraArmEnd, ObjectTraceParams, TraceParams))
+		{
+			//if trace hit, shorten camera arm to hit location
+			CameraArmEnd = TraceHit.Location;
+		}
 	}
 
 	//tilt camera
 	CameraRot.Pitch += CameraTilt;
 	
-	//get game wave manager
-	if (!WaveManager)
+	//ocean state for this frame
+	const FOceanContext* Ocean = ACustomMeshTestGameMode::FindOceanContext(this);
+
+	//ensure camera does not go below waves - ocean mesh has no collision, so the waves are traced analytically
+	if (Ocean && Ocean->WaveManager)
 	{
-		AGameMode* GameMode = UGameplayStatics::GetGameMode(this);
-		if (GameMode)
+		FVector WaveHitLocation;
+		FVector WaveHitNormal;
+
+		if (Ocean->WaveManager->LineTraceWaves(CameraPos, CameraArmEnd, Ocean->Time, WaveHitLocation, WaveHitNormal))
 		{
-			ACustomMeshTestGameMode* CustomGameMode = Cast<ACustomMeshTestGameMode>(GameMode);
-			if (CustomGameMode)
-			{
-				WaveManager = CustomGameMode->GetWaveManager();
-			}
+			//if camera arm goes into the waves, shorten camera arm to the surface
+			CameraArmEnd = WaveHitLocation;
 		}
-	}
-
-	//ensure camera does not go below waves
-	if (WaveManager)
-	{
-		FVector WaveDisplacement = FVector::ZeroVector;
-		FVector WaveNormal = FVector::ZeroVector;
 
-		//get wave height at camera position
-		WaveManager->GetWaveDisplacementNormal(FVector2D(CameraPos.X, CameraPos.Y), GetWorld()->GetTimeSeconds(), WaveDisplacement, WaveNormal);
+		//get wave heights at the centre and corners of the camera's near plane, so no part of the view dips under the surface
+		FQuat CameraQuat = CameraRot.Quaternion();
+		float NearHalfWidth = GNearClippingPlane * FMath::Tan(FMath::DegreesToRadians(CameraComp->FieldOfView * 0.5f));
+		float NearHalfHeight = NearHalfWidth / FMath::Max(CameraComp->AspectRatio, KINDA_SMALL_NUMBER);
+		FVector NearCentre = CameraArmEnd + CameraQuat.GetAxisX() * GNearClippingPlane;
+		FVector NearRight = CameraQuat.GetAxisY() * NearHalfWidth;
+		FVector NearUp = CameraQuat.GetAxisZ() * NearHalfHeight;
+
+		FVector NearPoints[5] = { NearCentre, NearCentre + NearRight + NearUp, NearCentre + NearRight - NearUp, NearCentre - NearRight + NearUp, NearCentre - NearRight - NearUp };
+		CameraSamplePositions.SetNumUninitialized(5);
+		for (int32 i = 0; i < 5; i++)
+		{
+			CameraSamplePositions[i] = FVector2D(NearPoints[i].X, NearPoints[i].Y);
+		}
+		Ocean->WaveManager->GetWaveHeightNormalBatch(CameraSamplePositions, Ocean->Time, CameraSampleHeights, CameraSampleNormals);
 
-		if (WaveDisplacement.Z > CameraPos.Z)
+		//lift the camera by the most any point is under the surface
+		float Lift = 0.f;
+		for (int32 i = 0; i < 5; i++)
 		{
-			//set camera height to wave height
-			CameraPos.Z = WaveDisplacement.Z;
+			Lift = FMath::Max(Lift, CameraSampleHeights[i] + CameraWaterClearance - NearPoints[i].Z);
 		}
+		CameraArmEnd.Z += Lift;
 	}
 
+	CameraPos = CameraArmEnd;
+
 	//actually move and rotate camera
 	CameraComp->SetWorldLocationAndRotation(CameraPos, CameraRot);
 }
@@ -559,16 +731,13 @@ void ABoat::HandleMovement(float DeltaTime)
 	//Sail power
 	FVector Wind = FVector::ZeroVector;
 
-	//get game wind vector
-	AGameMode* GameMode = UGameplayStatics::GetGameMode(this);
-	if (GameMode)
+	//get game wind vector for this frame
+	const FOceanContext* Ocean = ACustomMeshTestGameMode::FindOceanContext(this);
+	if (Ocean)
 	{
-		ACustomMeshTestGameMode* CustomGameMode = Cast<ACustomMeshTestGameMode>(GameMode);
-		if (CustomGameMode)
-		{
-			Wind = CustomGameMode->Wind;
-		}
+		Wind = Ocean->Wind;
 	}
+
 	//find main sail normal in world space
 	FVector WorldSailVector = (GetActorRotation() + FRotator(0.f, SailPosition, 0.f)).Vector();
 
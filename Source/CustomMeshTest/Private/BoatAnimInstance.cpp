@@ -4,6 +4,19 @@
 #include "BoatAnimInstance.h"
 
 
+UBoatAnimInstance::UBoatAnimInstance()
+{
+	//native animation params
+	bNativeEvaluation = false;
+
+	//default still pose params
+	bSkipStillPoses = true;
+	PoseChangeTolerance = 0.1f;
+	PoseSettleTime = 1.f;
+
+	PoseStillTime = 0.f;
+}
+
 // Ensure rot is in the -180 to 180 range
 void UBoatAnimInstance::ClampRot(float & Rot)
 {
@@ -76,3 +89,85 @@ void UBoatAnimInstance::SetLens(float Yaw, float Pitch)
 
 	ClampRot(LensPitch);
 }
+
+// Whether the pose needs evaluating this frame - false once the inputs have been still for the settle time and the oars aren't rowing
+bool UBoatAnimInstance::NeedsPoseUpdate(float DeltaTime)
+{
+	float Inputs[] = { RudderPos, SailPos, WindRot, WindPower, JibWindRot, JibWindPower, LensYaw, LensPitch, OarsOut ? 1.f : 0.f };
+	const int32 NumInputs = ARRAY_COUNT(Inputs);
+
+	bool Changed = PosedInputs.Num() != NumInputs;
+	for (int32 i = 0; i < NumInputs && !Changed; i++)
+	{
+		Changed = FMath::Abs(Inputs[i] - PosedInputs[i]) > PoseChangeTolerance;
+	}
+
+	if (Changed)
+	{
+		PosedInputs.SetNumUninitialized(NumInputs);
+		for (int32 i = 0; i < NumInputs; i++)
+		{
+			PosedInputs[i] = Inputs[i];
+		}
+		PoseStillTime = 0.f;
+	}
+	else
+	{
+		PoseStillTime += DeltaTime;
+	}
+
+	//rowing animates by itself, otherwise keep evaluating a little after the last change so anything blending in the anim graph can settle
+	return !bSkipStillPoses || RowSpeed != 0.f || PoseStillTime <= PoseSettleTime;
+}
+
+// Create the proxy the anim update and evaluation run on
+FAnimInstanceProxy* UBoatAnimInstance::CreateAnimInstanceProxy()
+{
+	return new FBoatAnimInstanceProxy(this);
+}
+
+// Copy the anim instance's inputs on the game thread before the update runs
+void FBoatAnimInstanceProxy::PreUpdate(UAnimInstance* InAnimInstance, float DeltaSeconds)
+{
+	FAnimInstanceProxy::PreUpdate(InAnimInstance, DeltaSeconds);
+
+	UBoatAnimInstance* BoatAnim = CastChecked<UBoatAnimInstance>(InAnimInstance);
+	bNativeEvaluation = BoatAnim->bNativeEvaluation;
+	RudderBone = BoatAnim->RudderBone;
+	SailBone = BoatAnim->SailBone;
+	JibBone = BoatAnim->JibBone;
+	LensYawBone = BoatAnim->LensYawBone;
+	LensPitchBone = BoatAnim->LensPitchBone;
+	RudderPos = BoatAnim->RudderPos;
+	SailPos = BoatAnim->SailPos;
+	JibWindRot = BoatAnim->JibWindRot;
+	LensYaw = BoatAnim->LensYaw;
+	LensPitch = BoatAnim->LensPitch;
+	Rowing = BoatAnim->OarsOut || BoatAnim->RowSpeed != 0.f;
+}
+
+// Build the pose from the reference pose and the part rotations, if native evaluation is on and the oars are stowed
+bool FBoatAnimInstanceProxy::Evaluate(FPoseContext& Output)
+{
+	//oar strokes are authored in the anim graph
+	if (!bNativeEvaluation || Rowing) return false;
+
+	Output.Pose.ResetToRefPose();
+	TurnBone(Output, RudderBone, FVector::UpVector, RudderPos);
+	TurnBone(Output, SailBone, FVector::UpVector, SailPos);
+	TurnBone(Output, JibBone, FVector::UpVector, JibWindRot);
+	TurnBone(Output, LensYawBone, FVector::UpVector, LensYaw);
+	TurnBone(Output, LensPitchBone, FVector::RightVector, LensPitch);
+	return true;
+}
+
+// Turn a bone from its reference pose by an angle in degrees about one of its axes
+void FBoatAnimInstanceProxy::TurnBone(FPoseContext &Output, FBoneReference &Bone, FVector Axis, float Degrees)
+{
+	const FBoneContainer &RequiredBones = Output.Pose.GetBoneContainer();
+	Bone.Initialize(RequiredBones);
+	if (!Bone.IsValid(RequiredBones)) return;
+
+	FTransform &BoneTransform = Output.Pose[Bone.GetCompactPoseIndex(RequiredBones)];
+	BoneTransform.SetRotation(BoneTransform.GetRotation() * FQuat(Axis, FMath::DegreesToRadians(Degrees)));
+}
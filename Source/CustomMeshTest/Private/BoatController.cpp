@@ -4,6 +4,8 @@
 #include "Boat.h"
 #include "Ocean.h"
 #include "SkySphere.h"
+#include "WaveManager.h"
+#include "CustomMeshTestGameMode.h"
 #include "BoatController.h"
 
 
@@ -52,6 +54,10 @@ ABoatController::ABoatController(const FObjectInitializer& ObjectInitializer) :
 
 	LensDoubleTouchTime = 0.4f;
 
+	//ocean occlusion params
+
+	OceanOcclusionClearance = 100.f;
+
 	//prev touch initialization
 
 	PrevTouch.SetNumUninitialized(5);
@@ -91,10 +97,8 @@ void ABoatController::HandleMoveOcean()
 {
 	if (Ocean)
 	{
-		//move ocean to boat location (only x and y)
-		Ocean->SetActorLocation(FVector(DrivingBoat->GetActorLocation().X, DrivingBoat->GetActorLocation().Y, Ocean->GetActorLocation().Z));
-		//rotate ocean to controller (camera) rotation
-		Ocean->SetActorRotation(FRotator(0.f, GetControlRotation().Yaw, 0.f));
+		//move ocean to boat location (only x and y) and rotate ocean to controller (camera) rotation
+		Ocean->FollowView(FVector(DrivingBoat->GetActorLocation().X, DrivingBoat->GetActorLocation().Y, Ocean->GetActorLocation().Z), GetControlRotation().Yaw);
 	}
 	if (SkySphere)
 	{
@@ -134,6 +138,41 @@ float ABoatController::SwipeAmountFromWorld(FVector2D SwipeStart, FVector2D Swip
 	return (WorldEnd - WorldStart) | (SwipeEnd - SwipeStart);
 }
 
+// Whether a wave between the camera and a touch zone hides it, ignoring the water within the clearance of the zone so zones at the waterline can still be touched
+bool ABoatController::IsHiddenByOcean(FVector ZoneLocation)
+{
+	//ocean state for this frame
+	const FOceanContext* Ocean = ACustomMeshTestGameMode::FindOceanContext(this);
+	if (!Ocean || !Ocean->WaveManager || !DrivingBoat) return false;
+
+	FVector CameraLocation = DrivingBoat->GetCameraWorldLocation();
+	FVector ToZone = ZoneLocation - CameraLocation;
+	float ZoneDepth = ToZone.Size();
+	if (ZoneDepth <= OceanOcclusionClearance) return false;
+
+	//trace from the camera to just short of the zone
+	FVector HitLocation;
+	FVector HitNormal;
+	return Ocean->WaveManager->LineTraceWaves(CameraLocation, CameraLocation + ToZone * ((ZoneDepth - OceanOcclusionClearance) / ZoneDepth), Ocean->Time, HitLocation, HitNormal);
+}
+
+// Find where a screen position (e.g. a touch) looks onto the ocean surface
+bool ABoatController::GetOceanLocationAtScreenPosition(FVector2D ScreenPosition, FVector &OceanLocation, float MaxDistance)
+{
+	//ocean state for this frame
+	const FOceanContext* Ocean = ACustomMeshTestGameMode::FindOceanContext(this);
+	if (!Ocean || !Ocean->WaveManager) return false;
+
+	//find the world ray under the screen position
+	FVector RayOrigin;
+	FVector RayDirection;
+	if (!DeprojectScreenPositionToWorld(ScreenPosition.X, ScreenPosition.Y, RayOrigin, RayDirection)) return false;
+
+	//trace the ray against the waves
+	FVector OceanNormal;
+	return Ocean->WaveManager->LineTraceWaves(RayOrigin, RayOrigin + RayDirection * MaxDistance, Ocean->Time, OceanLocation, OceanNormal);
+}
+
 // Handle all touch related input
 bool ABoatController::InputTouch(uint32 Handle, ETouchType::Type Type, const FVector2D &TouchLocation, FDateTime DeviceTimestamp, uint32 TouchpadIndex)
 {
@@ -150,6 +189,8 @@ bool ABoatController::InputTouch(uint32 Handle, ETouchType::Type Type, const FVe
 			//closer things have more priority, so set default to a large number (lowest priority)
 			float PriorityDepth = 10000;
 
+			//a wave between the camera and a touch zone hides it, each zone under the touch is traced to on its own
+
 			//rudder
 
 			FVector2D RudderScreenPos;
@@ -159,7 +200,7 @@ bool ABoatController::InputTouch(uint32 Handle, ETouchType::Type Type, const FVe
 			float RudderCamDepth = (DrivingBoat->GetCameraWorldLocation() - DrivingBoat->GetRudderWorldLocation()).Size();
 
 			//touch location is within rudder touch radius and depth takes priority
-			if ((RudderScreenPos - TouchLocation).Size() < RudderTouchRadius && RudderCamDepth < PriorityDepth)
+			if ((RudderScreenPos - TouchLocation).Size() < RudderTouchRadius && RudderCamDepth < PriorityDepth && !IsHiddenByOcean(DrivingBoat->GetRudderWorldLocation()))
 			{
 				//set as new type to use and set new priority depth
 				LastTouch[Handle] = ELastTouchType::ELT_Rudder;
@@ -174,7 +215,7 @@ bool ABoatController::InputTouch(uint32 Handle, ETouchType::Type Type, const FVe
 			float SailCamDepth = (DrivingBoat->GetCameraWorldLocation() - DrivingBoat->GetSailWorldLocation()).Size();
 
 			//touch location is within main sail touch radius and depth takes priority
-			if ((SailScreenPos - TouchLocation).Size() < SailTouchRadius && SailCamDepth < PriorityDepth)
+			if ((SailScreenPos - TouchLocation).Size() < SailTouchRadius && SailCamDepth < PriorityDepth && !IsHiddenByOcean(DrivingBoat->GetSailWorldLocation()))
 			{
 				//set as new type to use and set new priority depth
 				LastTouch[Handle] = ELastTouchType::ELT_Sail;
@@ -189,7 +230,7 @@ bool ABoatController::InputTouch(uint32 Handle, ETouchType::Type Type, const FVe
 			float JibSailCamDepth = (DrivingBoat->GetCameraWorldLocation() - DrivingBoat->GetJibSailWorldLocation()).Size();
 
 			//touch location is within jib sail touch radius and depth takes priority
-			if ((JibSailScreenPos - TouchLocation).Size() < JibSailTouchRadius && JibSailCamDepth < PriorityDepth)
+			if ((JibSailScreenPos - TouchLocation).Size() < JibSailTouchRadius && JibSailCamDepth < PriorityDepth && !IsHiddenByOcean(DrivingBoat->GetJibSailWorldLocation()))
 			{
 				//set as new type to use and set new priority depth
 				LastTouch[Handle] = ELastTouchType::ELT_JibSail;
@@ -204,7 +245,7 @@ bool ABoatController::InputTouch(uint32 Handle, ETouchType::Type Type, const FVe
 			float LensCamDepth = (DrivingBoat->GetCameraWorldLocation() - DrivingBoat->GetLensWorldLocation()).Size();
 
 			//touch location is within lens touch radius and depth takes priority
-			if ((LensScreenPos - TouchLocation).Size() < LensTouchRadius && LensCamDepth < PriorityDepth)
+			if ((LensScreenPos - TouchLocation).Size() < LensTouchRadius && LensCamDepth < PriorityDepth && !IsHiddenByOcean(DrivingBoat->GetLensWorldLocation()))
 			{
 				//set as new type to use and set new priority depth
 				LastTouch[Handle] = ELastTouchType::ELT_Lens;
@@ -219,27 +260,18 @@ bool ABoatController::InputTouch(uint32 Handle, ETouchType::Type Type, const FVe
 			float OarRightCamDepth = 10000;
 			
 			//different world space locations for in or out oars
-			if (DrivingBoat->GetOarsOut())
-			{
-				//get screen space location of oars
-				UGameplayStatics::ProjectWorldToScreen(this, DrivingBoat->GetOarOutLeftWorldLocation(), OarLeftScreenPos);
-				UGameplayStatics::ProjectWorldToScreen(this, DrivingBoat->GetOarOutRightWorldLocation(), OarRightScreenPos);
-				//get depth of oars from camera
-				OarLeftCamDepth = (DrivingBoat->GetCameraWorldLocation() - DrivingBoat->GetOarOutLeftWorldLocation()).Size();
-				OarRightCamDepth = (DrivingBoat->GetCameraWorldLocation() - DrivingBoat->GetOarOutRightWorldLocation()).Size();
-			}
-			else
-			{
-				//get screen space location of oars
-				UGameplayStatics::ProjectWorldToScreen(this, DrivingBoat->GetOarInLeftWorldLocation(), OarLeftScreenPos);
-				UGameplayStatics::ProjectWorldToScreen(this, DrivingBoat->GetOarInRightWorldLocation(), OarRightScreenPos);
-				//get depth of oars from camera
-				OarLeftCamDepth = (DrivingBoat->GetCameraWorldLocation() - DrivingBoat->GetOarInLeftWorldLocation()).Size();
-				OarRightCamDepth = (DrivingBoat->GetCameraWorldLocation() - DrivingBoat->GetOarInRightWorldLocation()).Size();
-			}
+			FVector OarLeftLocation = DrivingBoat->GetOarsOut() ? DrivingBoat->GetOarOutLeftWorldLocation() : DrivingBoat->GetOarInLeftWorldLocation();
+			FVector OarRightLocation = DrivingBoat->GetOarsOut() ? DrivingBoat->GetOarOutRightWorldLocation() : DrivingBoat->GetOarInRightWorldLocation();
+
+			//get screen space location of oars
+			UGameplayStatics::ProjectWorldToScreen(this, OarLeftLocation, OarLeftScreenPos);
+			UGameplayStatics::ProjectWorldToScreen(this, OarRightLocation, OarRightScreenPos);
+			//get depth of oars from camera
+			OarLeftCamDepth = (DrivingBoat->GetCameraWorldLocation() - OarLeftLocation).Size();
+			OarRightCamDepth = (DrivingBoat->GetCameraWorldLocation() - OarRightLocation).Size();
 
 			//touch location is within left oar touch radius and depth takes priority
-			if ((OarLeftScreenPos - TouchLocation).Size() < (DrivingBoat->GetOarsOut() ? OarOutTouchRadius : OarInTouchRadius) && OarLeftCamDepth < PriorityDepth)
+			if ((OarLeftScreenPos - TouchLocation).Size() < (DrivingBoat->GetOarsOut() ? OarOutTouchRadius : OarInTouchRadius) && OarLeftCamDepth < PriorityDepth && !IsHiddenByOcean(OarLeftLocation))
 			{
 				//set as new type to use and set new priority depth
 				LastTouch[Handle] = ELastTouchType::ELT_Oar;
@@ -247,7 +279,7 @@ bool ABoatController::InputTouch(uint32 Handle, ETouchType::Type Type, const FVe
 			}
 
 			//touch location is within right oar touch radius and depth takes priority
-			if ((OarRightScreenPos - TouchLocation).Size() < (DrivingBoat->GetOarsOut() ? OarOutTouchRadius : OarInTouchRadius) && OarRightCamDepth < PriorityDepth)
+			if ((OarRightScreenPos - TouchLocation).Size() < (DrivingBoat->GetOarsOut() ? OarOutTouchRadius : OarInTouchRadius) && OarRightCamDepth < PriorityDepth && !IsHiddenByOcean(OarRightLocation))
 			{
 				//set as new type to use and set new priority depth
 				LastTouch[Handle] = ELastTouchType::ELT_Oar;
@@ -2,9 +2,11 @@
 
 #include "CustomMeshTest.h"
 #include "FloatComponent.h"
-#include "FoamDecal.h"
+#include "FoamManager.h"
 #include "CustomMeshTestGameMode.h"
 #include "BuoyAnimInstance.h"
+#include "OceanSignificanceManager.h"
+#include "OceanSpatialHash.h"
 #include "Buoy.h"
 
 
@@ -12,6 +14,8 @@
 ABuoy::ABuoy()
 {
 	PrimaryActorTick.bCanEverTick = true;
+	SignificanceManager = nullptr;
+	SpatialHash = nullptr;
 
 	//bouy mesh and anims
 	BuoyMesh = CreateDefaultSubobject<USkeletalMeshComponent>(TEXT("BuoyMesh"));
@@ -23,6 +27,10 @@ ABuoy::ABuoy()
 	BuoyMesh->SetSkeletalMesh(BuoyMeshClassFinder.Object);
 	BuoyMesh->SetAnimInstanceClass(BuoyAnimClassFinder.Class);
 
+	//only animate buoys that are being seen, and less often the smaller they are on screen
+	BuoyMesh->MeshComponentUpdateFlag = EMeshComponentUpdateFlag::OnlyTickPoseWhenRendered;
+	BuoyMesh->bEnableUpdateRateOptimizations = true;
+
 	//make sure it blocks the camera
 	BuoyMesh->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
 	BuoyMesh->SetCollisionObjectType(ECollisionChannel::ECC_WorldDynamic);
@@ -37,6 +45,8 @@ ABuoy::ABuoy()
 	//foam params
 	FoamInterval = 2.f;
 	FoamSpawnDistance = 3000.f;
+	FoamMapRadius = 120.f;
+	FoamMapRate = 0.5f;
 }
 
 // Called when the game starts or when spawned
@@ -46,26 +56,42 @@ void ABuoy::BeginPlay()
 
 	//set anim for code access
 	BuoyAnim = Cast<UBuoyAnimInstance>(BuoyMesh->GetAnimInstance());
+
+	//tick and animate by how much the buoy matters to the view
+	const FOceanContext* Ocean = ACustomMeshTestGameMode::FindOceanContext(this);
+	SignificanceManager = Ocean ? Ocean->SignificanceManager : nullptr;
+	if (SignificanceManager)
+	{
+		SignificanceManager->RegisterActor(this);
+	}
+
+	SpatialHash = Ocean ? Ocean->SpatialHash : nullptr;
 	
 }
 
+// Called when the buoy is removed from play
+void ABuoy::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (SignificanceManager)
+	{
+		SignificanceManager->UnregisterActor(this);
+		SignificanceManager = nullptr;
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
 // Called every frame
 void ABuoy::Tick( float DeltaTime )
 {
+	double TickStart = FPlatformTime::Seconds();
+
 	Super::Tick( DeltaTime );
 
-	FVector Wind = FVector::ZeroVector;
-
-	//get game wind vector
-	AGameMode* GameMode = UGameplayStatics::GetGameMode(this);
-	if (GameMode)
-	{
-		ACustomMeshTestGameMode* CustomGameMode = Cast<ACustomMeshTestGameMode>(GameMode);
-		if (CustomGameMode)
-		{
-			Wind = CustomGameMode->Wind;
-		}
-	}
+	//get game wind vector and foam manager for this frame
+	const FOceanContext* Ocean = ACustomMeshTestGameMode::FindOceanContext(this);
+	FVector Wind = Ocean ? Ocean->Wind : FVector::ZeroVector;
+	FoamManager = Ocean ? Ocean->FoamManager : nullptr;
 
 	//lerp toward rotations for compass and wind vane
 	VaneRot = FMath::Lerp(Wind.Rotation().Yaw - GetActorRotation().Yaw, VaneRot, FMath::Pow(VaneResist, DeltaTime));
@@ -76,24 +102,36 @@ void ABuoy::Tick( float DeltaTime )
 		//pass on to anim
 		BuoyAnim->SetWind(VaneRot);
 		BuoyAnim->SetNorth(CompassRot);
+
+		//don't evaluate a pose that hasn't moved
+		BuoyMesh->bNoSkeletonUpdate = !BuoyAnim->NeedsPoseUpdate(DeltaTime);
 	}	
 	
+	//foam map
+	if (FoamManager)
+	{
+		FoamManager->SplatFoamMap(GetActorLocation(), FoamMapRadius, FoamMapRate*DeltaTime);
+	}
+
 	//foam decals
 	FoamIntervalTimer += DeltaTime;
 
-	//don't spawn foam if foam is too far away from player to prevent unessecary performance loss
-	if ((UGameplayStatics::GetPlayerPawn(this, 0)->GetActorLocation() - GetActorLocation()).Size() < FoamSpawnDistance && FoamIntervalTimer > FoamInterval)
+	//don't spawn foam if no vessel is close enough to see it to prevent unessecary performance loss
+	if (FoamIntervalTimer > FoamInterval && SpatialHash && SpatialHash->AnyInRadius(GetActorLocation(), FoamSpawnDistance, AOceanSpatialHash::GetKindMask(EOceanSpatialKind::OSK_Vessel)))
 	{
 		FoamIntervalTimer -= FoamInterval;
 
-		FActorSpawnParameters SpawnParams;
-		SpawnParams.Owner = this;
-		SpawnParams.Instigator = Instigator;
+		//spawm foam patch, unless the buoy is too insignificant for it
+		if (FoamManager && (!SignificanceManager || SignificanceManager->IsFoamAllowed(this)))
+		{
+			FoamManager->SpawnFoam(FVector(GetActorLocation().X, GetActorLocation().Y, 5.f), 1.f, 0.2f, FMath::RandRange(-20.f, 20.f), this);
+		}
 
-		//spawm foam decal
-		AFoamDecal* NewFoam = GetWorld()->SpawnActor<AFoamDecal>(FVector(GetActorLocation().X, GetActorLocation().Y, 5.f), FRotator::ZeroRotator, SpawnParams);
-		NewFoam->RotateRate = FMath::RandRange(-20.f, 20.f);
+	}
 
+	if (SignificanceManager)
+	{
+		SignificanceManager->RecordTickCost(FPlatformTime::Seconds() - TickStart);
 	}
 }
 
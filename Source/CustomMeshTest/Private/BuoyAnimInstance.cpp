@@ -4,6 +4,21 @@
 #include "BuoyAnimInstance.h"
 
 
+UBuoyAnimInstance::UBuoyAnimInstance()
+{
+	//native animation params
+	bNativeEvaluation = false;
+
+	//default still pose params
+	bSkipStillPoses = true;
+	PoseChangeTolerance = 0.1f;
+	PoseSettleTime = 0.5f;
+
+	PosedWindRot = 0.f;
+	PosedNorthRot = 0.f;
+	PoseStillTime = 0.f;
+}
+
 // Ensure rot is in the -180 to 180 range
 void UBuoyAnimInstance::ClampRot(float & Rot)
 {
@@ -33,3 +48,61 @@ void UBuoyAnimInstance::SetNorth(float Rot)
 	ClampRot(NorthRot);
 }
 
+// Whether the pose needs evaluating this frame - false once the part rotations have been still for the settle time
+bool UBuoyAnimInstance::NeedsPoseUpdate(float DeltaTime)
+{
+	if (FMath::Abs(WindRot - PosedWindRot) > PoseChangeTolerance || FMath::Abs(NorthRot - PosedNorthRot) > PoseChangeTolerance)
+	{
+		PosedWindRot = WindRot;
+		PosedNorthRot = NorthRot;
+		PoseStillTime = 0.f;
+	}
+	else
+	{
+		PoseStillTime += DeltaTime;
+	}
+
+	//keep evaluating a little after the last change so anything blending in the anim graph can settle
+	return !bSkipStillPoses || PoseStillTime <= PoseSettleTime;
+}
+
+// Create the proxy the anim update and evaluation run on
+FAnimInstanceProxy* UBuoyAnimInstance::CreateAnimInstanceProxy()
+{
+	return new FBuoyAnimInstanceProxy(this);
+}
+
+// Copy the anim instance's inputs on the game thread before the update runs
+void FBuoyAnimInstanceProxy::PreUpdate(UAnimInstance* InAnimInstance, float DeltaSeconds)
+{
+	FAnimInstanceProxy::PreUpdate(InAnimInstance, DeltaSeconds);
+
+	UBuoyAnimInstance* BuoyAnim = CastChecked<UBuoyAnimInstance>(InAnimInstance);
+	bNativeEvaluation = BuoyAnim->bNativeEvaluation;
+	VaneBone = BuoyAnim->VaneBone;
+	CompassBone = BuoyAnim->CompassBone;
+	WindRot = BuoyAnim->WindRot;
+	NorthRot = BuoyAnim->NorthRot;
+}
+
+// Build the pose from the reference pose and the part rotations, if native evaluation is on
+bool FBuoyAnimInstanceProxy::Evaluate(FPoseContext& Output)
+{
+	if (!bNativeEvaluation) return false;
+
+	Output.Pose.ResetToRefPose();
+	TurnBone(Output, VaneBone, FVector::UpVector, WindRot);
+	TurnBone(Output, CompassBone, FVector::UpVector, NorthRot);
+	return true;
+}
+
+// Turn a bone from its reference pose by an angle in degrees about one of its axes
+void FBuoyAnimInstanceProxy::TurnBone(FPoseContext &Output, FBoneReference &Bone, FVector Axis, float Degrees)
+{
+	const FBoneContainer &RequiredBones = Output.Pose.GetBoneContainer();
+	Bone.Initialize(RequiredBones);
+	if (!Bone.IsValid(RequiredBones)) return;
+
+	FTransform &BoneTransform = Output.Pose[Bone.GetCompactPoseIndex(RequiredBones)];
+	BoneTransform.SetRotation(BoneTransform.GetRotation() * FQuat(Axis, FMath::DegreesToRadians(Degrees)));
+}
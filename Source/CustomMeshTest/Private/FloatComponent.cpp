@@ -3,6 +3,8 @@
 #include "CustomMeshTest.h"
 #include "CustomMeshTestGameMode.h"
 #include "WaveManager.h"
+#include "FloatSystem.h"
+#include "OceanSpatialHash.h"
 #include "FloatComponent.h"
 
 
@@ -19,8 +21,35 @@ UFloatComponent::UFloatComponent()
 	BouyancyAngular = 250.f;
 	BouyancyDrag = 0.05f;
 	BouyancyAngularResist = 0.05f;
-	IsInAir = false;
 	Slide = 2.f;
+
+	//fixed step params
+	bUseFloatSystem = true;
+	bFixedTimestep = true;
+	StepRate = 60.f;
+	MaxSubsteps = 4;
+	StepAccumulator = 0.f;
+	FloatSystem = nullptr;
+	FloatSystemIndex = INDEX_NONE;
+	bRideOnly = false;
+
+	//hull params
+	bHullHydrostatics = false;
+	HullMesh = nullptr;
+	HullExtent = FVector(200.f, 80.f, 40.f);
+	HullDraft = 20.f;
+	HullPressureScale = 0.f;
+
+	//spatial index params
+	SpatialKind = EOceanSpatialKind::OSK_Float;
+	SpatialHash = nullptr;
+
+	//contact params
+	bFloatContacts = true;
+	ContactRadius = 60.f;
+	ContactHalfLength = 0.f;
+	ContactMass = 100.f;
+	ContactRestitution = 0.3f;
 }
 
 
@@ -30,7 +59,69 @@ void UFloatComponent::BeginPlay()
 	Super::BeginPlay();
 
 	//set initial ocean position to owner location
-	PositionOnOcean = GetOwner()->GetActorLocation();
+	State.Location = GetOwner()->GetActorLocation();
+	State.Rotation = GetOwner()->GetActorQuat();
+	State.PositionOnOcean = State.Location;
+	PreviousState = State;
+
+	BuildHull();
+
+	const FOceanContext* Ocean = ACustomMeshTestGameMode::FindOceanContext(this);
+
+	//index the owner so it can be found by location
+	SpatialHash = Ocean ? Ocean->SpatialHash : nullptr;
+	if (SpatialHash)
+	{
+		SpatialHash->RegisterActor(GetOwner(), SpatialKind);
+	}
+
+	//hand stepping over to the world float system
+	if (bUseFloatSystem)
+	{
+		FloatSystem = Ocean ? Ocean->FloatSystem : nullptr;
+		if (FloatSystem)
+		{
+			FloatSystemIndex = FloatSystem->RegisterFloat(this, State);
+			SetComponentTickEnabled(false);
+		}
+	}
+}
+
+// Called when the component is removed from play
+void UFloatComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (FloatSystem)
+	{
+		//keep the latest state in case the float carries on by itself
+		State = GetState();
+		FloatSystem->UnregisterFloat(this);
+		FloatSystem = nullptr;
+		FloatSystemIndex = INDEX_NONE;
+	}
+
+	if (SpatialHash)
+	{
+		SpatialHash->UnregisterActor(GetOwner());
+		SpatialHash = nullptr;
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+// Physics state of this float, wherever it is held
+FFloatState& UFloatComponent::GetState()
+{
+	if (FloatSystem)
+	{
+		return FloatSystem->GetFloatState(FloatSystemIndex);
+	}
+	return State;
+}
+
+// Index of this float's state in the world float system
+void UFloatComponent::SetFloatSystemIndex(int32 Index)
+{
+	FloatSystemIndex = Index;
 }
 
 
@@ -39,152 +130,330 @@ void UFloatComponent::TickComponent( float DeltaTime, ELevelTick TickType, FActo
 {
 	Super::TickComponent( DeltaTime, TickType, ThisTickFunction );
 
-	//get game wave manager
-	if (!WaveManager)
+	//waves and time for this frame
+	const FOceanContext* Ocean = ACustomMeshTestGameMode::FindOceanContext(this);
+	WaveManager = Ocean ? Ocean->WaveManager : nullptr;
+	if (WaveManager)
 	{
-		AGameMode* GameMode = UGameplayStatics::GetGameMode(this);
-		if (GameMode)
+		float Time = Ocean->Time;
+
+		if (!bFixedTimestep)
 		{
-			ACustomMeshTestGameMode* CustomGameMode = Cast<ACustomMeshTestGameMode>(GameMode);
-			if (CustomGameMode)
-			{
-				WaveManager = CustomGameMode->GetWaveManager();
-			}
+			//one step of the frame's length, shown as is
+			StepFloat(DeltaTime, Time);
+			ApplyInterpolatedTransform(1.f);
+			return;
 		}
-	}
-	if (WaveManager)
-	{
 
-		FVector ForwardVectorOnOcean = FRotationMatrix(GetOwner()->GetActorRotation()).GetScaledAxis(EAxis::X);
+		//fixed length steps so behaviour doesn't change with frame rate
+		float StepTime = 1.f / FMath::Max(StepRate, 1.f);
+		StepAccumulator += DeltaTime;
 
+		//after a hitch only catch up so far, dropping the rest rather than launching the float
+		int32 NumSteps = FMath::FloorToInt(StepAccumulator / StepTime);
+		if (NumSteps > FMath::Max(MaxSubsteps, 1))
+		{
+			NumSteps = FMath::Max(MaxSubsteps, 1);
+			StepAccumulator = StepTime * NumSteps;
+		}
 
-		if (!IsInAir) //only drag in water
+		for (int32 i = 0; i < NumSteps; i++)
 		{
+			StepAccumulator -= StepTime;
+			StepFloat(StepTime, Time - StepAccumulator);
+		}
 
-			FVector VelocityNormal = Velocity.GetSafeNormal();
+		//show the float part way between its last two states
+		ApplyInterpolatedTransform(StepAccumulator / StepTime);
+	}
+}
 
-			//calculate drag based on velocity and oreintation - moving = more drag, moving sideways = even more drag (SideDrag)
-			float CurrentDrag = Drag * FMath::Pow(FMath::Abs((1.f - VelocityNormal.Size()) - (ForwardVectorOnOcean | VelocityNormal)), SideDrag);
+// Advance the physics state by one step, sampling the waves at the float's location
+void UFloatComponent::StepFloat(float StepTime, float Time)
+{
+	PreviousState = State;
 
-			//Velocity due to sliding on waves
-			FVector DropVector = FVector::VectorPlaneProject(FRotationMatrix(GetOwner()->GetActorRotation()).GetScaledAxis(EAxis::Z), FVector(0.f, 0.f, -1.f));
-			Velocity += DropVector * Slide;
+	//find wave displacement and normal at float's location
+	FVector WaveDisplacement = FVector::ZeroVector;
+	FVector WaveNormal = FVector::ZeroVector;
+	WaveManager->GetWaveDisplacementNormal(FVector2D(State.Location.X, State.Location.Y), Time, WaveDisplacement, WaveNormal);
 
-			//Drag
-			Velocity.X *= FMath::Pow(CurrentDrag, DeltaTime);
-			Velocity.Y *= FMath::Pow(CurrentDrag, DeltaTime);
-			//Not the Z as this is used for bouyancy which has its own drag
+	if (HasHull())
+	{
+		//waves move sideways as well as up, so each hull vert needs the height of the surface that ends up under it rather than the displacement at its location
+		HullWorldVerts.Reset();
+		HullSamplePositions.Reset();
+		AppendHullSamples(State, HullWorldVerts, HullSamplePositions);
+		WaveManager->GetWaveHeightNormalBatch(HullSamplePositions, Time, HullHeights, HullNormals);
+
+		IntegrateFloat(State, StepTime, WaveDisplacement, WaveNormal, HullWorldVerts.GetData(), HullHeights.GetData());
+		return;
+	}
 
-			//estimate moving average for spray
-			CurrentCombinedDrag += 0.05 * ((Velocity - (Velocity * CurrentDrag)).Size() - CurrentCombinedDrag);
-		}
+	IntegrateFloat(State, StepTime, WaveDisplacement, WaveNormal);
+}
 
-		//add velocity to ocean position
-		PositionOnOcean.X += Velocity.X * DeltaTime;
-		PositionOnOcean.Y += Velocity.Y * DeltaTime;
+// Move the owner to its state between the previous and latest step
+void UFloatComponent::ApplyInterpolatedTransform(float Alpha)
+{
+	FVector Location = FMath::Lerp(PreviousState.Location, State.Location, Alpha);
+	FQuat Rotation = FQuat::Slerp(PreviousState.Rotation, State.Rotation, Alpha);
 
-		//Gravity and Bouyancy
+	//one transform update for both
+	GetOwner()->SetActorLocationAndRotation(Location, Rotation);
 
-		FVector WaveDisplacement = FVector::ZeroVector;
-		FVector WaveNormal = FVector::ZeroVector;
+	if (SpatialHash)
+	{
+		SpatialHash->MoveActor(GetOwner(), Location);
+	}
+}
 
-		//find wave displacement and normal at owner's location
-		WaveManager->GetWaveDisplacementNormal(FVector2D(GetOwner()->GetActorLocation().X, GetOwner()->GetActorLocation().Y), GetWorld()->GetTimeSeconds(), WaveDisplacement, WaveNormal);
+// Advance a physics state by one step given the waves at its location, and at each hull vert if the float has a hull
+void UFloatComponent::IntegrateFloat(FFloatState &FloatState, float StepTime, FVector WaveDisplacement, FVector WaveNormal, const FVector* HullVerts, const float* HullVertHeights) const
+{
+	FVector &Velocity = FloatState.Velocity;
+	FVector &AVelocity = FloatState.AVelocity;
+	FVector &PositionOnOcean = FloatState.PositionOnOcean;
 
-		//where the boat should be on the water
-		FVector NextPosition = FVector(PositionOnOcean.X + WaveDisplacement.X, PositionOnOcean.Y + WaveDisplacement.Y, GetOwner()->GetActorLocation().Z);
+	//float axes straight from the quaternion, no rotation matrices
+	FVector ForwardVectorOnOcean = FloatState.Rotation.GetAxisX();
+	FVector UpVector = FloatState.Rotation.GetAxisZ();
 
-		//if above where it should be
-		if (NextPosition.Z > (PositionOnOcean + WaveDisplacement).Z)
-		{
-			//apply gravity
-			Velocity.Z -= Gravity*DeltaTime;
-			//not in air if gravity has brought it back below again
-			IsInAir = (NextPosition.Z + (Velocity.Z)*DeltaTime > PositionOnOcean.Z + WaveDisplacement.Z); 
-		}
-		else
+
+	if (!FloatState.IsInAir) //only drag in water
+	{
+
+		FVector VelocityNormal = Velocity.GetSafeNormal();
+
+		//calculate drag based on velocity and oreintation - moving = more drag, moving sideways = even more drag (SideDrag)
+		float CurrentDrag = Drag * FMath::Pow(FMath::Abs((1.f - VelocityNormal.Size()) - (ForwardVectorOnOcean | VelocityNormal)), SideDrag);
+
+		//Velocity due to sliding on waves - with a hull the water pressure does this
+		if (!HullVerts)
 		{
-			IsInAir = false;
-			
-			//apply bouyancy - more bouyancy the more underwater it is
-			Velocity.Z += Bouyancy*DeltaTime*((PositionOnOcean + WaveDisplacement).Z - NextPosition.Z);
-			//bouyancy drag
-			Velocity.Z *= FMath::Pow(BouyancyDrag, DeltaTime);
+			FVector DropVector = FVector::VectorPlaneProject(UpVector, FVector(0.f, 0.f, -1.f));
+			Velocity += DropVector * Slide;
 		}
 
-		//apply gravity/bouyancy to position
-		NextPosition.Z += Velocity.Z * DeltaTime;
+		//Drag
+		Velocity.X *= FMath::Pow(CurrentDrag, StepTime);
+		Velocity.Y *= FMath::Pow(CurrentDrag, StepTime);
+		//Not the Z as this is used for bouyancy which has its own drag
+
+		//estimate moving average for spray
+		FloatState.CurrentCombinedDrag += 0.05 * ((Velocity - (Velocity * CurrentDrag)).Size() - FloatState.CurrentCombinedDrag);
+	}
+
+	//add velocity to ocean position
+	PositionOnOcean.X += Velocity.X * StepTime;
+	PositionOnOcean.Y += Velocity.Y * StepTime;
+
+	if (HullVerts && HullVertHeights)
+	{
+		//water pressure over the hull lifts and turns the float, instead of a spring toward the wave at its centre and its normal
+		ApplyHullPressure(FloatState, StepTime, HullVerts, HullVertHeights);
+		FloatState.Location = FVector(PositionOnOcean.X + WaveDisplacement.X, PositionOnOcean.Y + WaveDisplacement.Y, FloatState.Location.Z + Velocity.Z * StepTime);
+		IntegrateRotation(FloatState, StepTime);
+		return;
+	}
 
-		//actually set new location
-		GetOwner()->SetActorLocation(NextPosition);
+	//Gravity and Bouyancy
 
-		//Rotation
+	//where the boat should be on the water
+	FVector NextPosition = FVector(PositionOnOcean.X + WaveDisplacement.X, PositionOnOcean.Y + WaveDisplacement.Y, FloatState.Location.Z);
 
-		if (IsInAir)
+	//if above where it should be
+	if (NextPosition.Z > (PositionOnOcean + WaveDisplacement).Z)
+	{
+		//apply gravity
+		Velocity.Z -= Gravity*StepTime;
+		//not in air if gravity has brought it back below again
+		FloatState.IsInAir = (NextPosition.Z + (Velocity.Z)*StepTime > PositionOnOcean.Z + WaveDisplacement.Z); 
+	}
+	else
+	{
+		FloatState.IsInAir = false;
+		
+		//apply bouyancy - more bouyancy the more underwater it is
+		Velocity.Z += Bouyancy*StepTime*((PositionOnOcean + WaveDisplacement).Z - NextPosition.Z);
+		//bouyancy drag
+		Velocity.Z *= FMath::Pow(BouyancyDrag, StepTime);
+	}
+
+	//apply gravity/bouyancy to position
+	NextPosition.Z += Velocity.Z * StepTime;
+
+	//actually set new location
+	FloatState.Location = NextPosition;
+
+	//Rotation
+
+	if (!FloatState.IsInAir)
+	{
+		//torque turning the float's up vector onto the ocean normal, its length is the sine of the angle between them
+		FVector AlignAxis = UpVector ^ WaveNormal;
+		float AlignSine = AlignAxis.Size();
+
+		if (AlignSine > KINDA_SMALL_NUMBER || (UpVector | WaveNormal) < 0.f)
 		{
-			//just keep spinning
-			GetOwner()->SetActorRotation(GetOwner()->GetActorRotation() + AVelocity*DeltaTime); 
+			//pull is proportional to the error under 1 degree and constant above it, upside down floats get the full pull
+			float AlignDegrees = (UpVector | WaveNormal) < 0.f ? 1.f : FMath::Min(FMath::RadiansToDegrees(AlignSine), 1.f);
+			FVector AlignDirection = AlignSine > KINDA_SMALL_NUMBER ? AlignAxis / AlignSine : ForwardVectorOnOcean;
+
+			AVelocity += AlignDirection * FMath::DegreesToRadians(AlignDegrees * BouyancyAngular) * StepTime;
 		}
-		else
-		{
-			//perfectly placed onto ocean surface and normal
-			FRotator IdealOceanRot = FRotationMatrix::MakeFromXY(FVector::VectorPlaneProject(ForwardVectorOnOcean, WaveNormal), FVector::VectorPlaneProject(FRotationMatrix(GetOwner()->GetActorRotation()).GetScaledAxis(EAxis::Y), WaveNormal)).Rotator();
+		//Yaw is using rudder (if boat), not governed by the ocean normal - is set by the boat
+		AVelocity *= FMath::Pow(BouyancyAngularResist, StepTime);
+	}
 
-			FRotator Delta = (IdealOceanRot - GetOwner()->GetActorRotation());
+	IntegrateRotation(FloatState, StepTime);
+}
 
-			//"Normalising" the rotation so it's only 1 degree in any direction max
+// Rotate a state by its angular velocity over one step
+void UFloatComponent::IntegrateRotation(FFloatState &FloatState, float StepTime)
+{
+	//exact for any step length so large steps don't blow up
+	float AngularSpeed = FloatState.AVelocity.Size();
+	if (AngularSpeed > KINDA_SMALL_NUMBER)
+	{
+		FloatState.Rotation = FQuat(FloatState.AVelocity / AngularSpeed, AngularSpeed * StepTime) * FloatState.Rotation;
+		//keep unit length over long sessions
+		FloatState.Rotation.Normalize();
+	}
+}
 
-			float DeltaAngleSize = FMath::Abs(Delta.Yaw) + FMath::Abs(Delta.Pitch) + FMath::Abs(Delta.Roll);//FMath::RadiansToDegrees(FMath::Acos(FVector::ForwardVector | DeltaVector));
+// Build the hull from the hull mesh, or a box if there isn't one
+void UFloatComponent::BuildHull()
+{
+	if (!bHullHydrostatics) return;
 
-			if (DeltaAngleSize > 1) //no dividing by zero
-			{
-				Delta *= 1 / DeltaAngleSize;
-			}
+	if (!HullMesh || !Hull.BuildFromStaticMesh(HullMesh, GetOwner()->GetActorScale3D()))
+	{
+		Hull.BuildBox(HullExtent);
+	}
 
-			AVelocity.Pitch += Delta.Pitch * DeltaTime * BouyancyAngular;
-			AVelocity.Roll += Delta.Roll * DeltaTime * BouyancyAngular;
-			//Yaw is using rudder (if boat), not governed by the ocean normal - is set by the boat
-			AVelocity *= FMath::Pow(BouyancyAngularResist, DeltaTime);
+	//every hull vert is a wave sample each step, so hull meshes should be a rough simplified shape
+	if (Hull.GetNumVerts() > 64)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Float hull on %s has %d verts - a simpler hull mesh keeps hull hydrostatics cheap."), *GetOwner()->GetName(), Hull.GetNumVerts());
+	}
 
+	//still water holds the hull up at its draft against gravity
+	float RestVolume = Hull.GetDisplacedVolume(HullDraft);
+	HullPressureScale = RestVolume > 0.f ? Gravity / RestVolume : 0.f;
+}
 
-			//for some reason AddActorWorldRotation causes problems
-			FRotator NewRotation = GetOwner()->GetActorRotation() + AVelocity*DeltaTime;
+// Change a state's velocities by one step of water pressure over the hull
+void UFloatComponent::ApplyHullPressure(FFloatState &FloatState, float StepTime, const FVector* WorldVerts, const float* WaveHeights) const
+{
+	FVector &Velocity = FloatState.Velocity;
+	FVector &AVelocity = FloatState.AVelocity;
 
-			GetOwner()->SetActorRotation(NewRotation);
-		}
+	FVector PressureForce;
+	FVector PressureTorque;
+	FloatState.IsInAir = !Hull.ComputePressure(WorldVerts, WaveHeights, FloatState.Location, PressureForce, PressureTorque);
+
+	Velocity += PressureForce * (HullPressureScale * StepTime);
+	Velocity.Z -= Gravity*StepTime;
+
+	if (!FloatState.IsInAir)
+	{
+		//bouyancy drag
+		Velocity.Z *= FMath::Pow(BouyancyDrag, StepTime);
+
+		//Yaw is using rudder (if boat), not governed by the water - is set by the boat
+		PressureTorque.Z = 0.f;
+		AVelocity += PressureTorque * (HullPressureScale / Hull.GetRadiusOfGyrationSquared() * StepTime);
+		AVelocity *= FMath::Pow(BouyancyAngularResist, StepTime);
 	}
 }
 
+// Whether the float is buoyed by water pressure over its hull rather than a single point
+bool UFloatComponent::HasHull() const
+{
+	return bHullHydrostatics && Hull.IsBuilt();
+}
+
+// Add the world position of each hull vert, and its position on the ocean plane to sample the waves at, for a physics state
+void UFloatComponent::AppendHullSamples(const FFloatState &FloatState, TArray<FVector> &WorldVerts, TArray<FVector2D> &SamplePositions) const
+{
+	Hull.AppendSamples(FloatState.Location, FloatState.Rotation, WorldVerts, SamplePositions);
+}
+
+// Whether the float system pushes this float apart from the floats it touches
+bool UFloatComponent::HasContactShape() const
+{
+	return bFloatContacts && ContactRadius > 0.f;
+}
+
+// Ends of the float's contact capsule on the ocean plane for a physics state, both at its centre for a circle
+void UFloatComponent::GetContactSegment(const FFloatState &FloatState, FVector &Start, FVector &End) const
+{
+	FVector Centre = FVector(FloatState.Location.X, FloatState.Location.Y, 0.f);
+	FVector Forward = FloatState.Rotation.GetAxisX();
+	Forward = FVector(Forward.X, Forward.Y, 0.f).GetSafeNormal() * ContactHalfLength;
+
+	Start = Centre - Forward;
+	End = Centre + Forward;
+}
+
+// Furthest the contact shape reaches from the float's centre
+float UFloatComponent::GetContactReach() const
+{
+	return ContactRadius + ContactHalfLength;
+}
+
+// Inverse of the float's mass, and of its moment of inertia about the vertical, for contact impulses
+void UFloatComponent::GetContactInverseMass(float &InvMass, float &InvInertia) const
+{
+	float Mass = FMath::Max(ContactMass, KINDA_SMALL_NUMBER);
+	InvMass = 1.f / Mass;
+
+	//a disc plus a rod the length of the capsule
+	float Inertia = Mass * (0.5f * ContactRadius * ContactRadius + ContactHalfLength * ContactHalfLength / 3.f);
+	InvInertia = Inertia > KINDA_SMALL_NUMBER ? 1.f / Inertia : 0.f;
+}
+
 // Input angular yaw velocity
 void UFloatComponent::SetYawVelocity(float Val)
 {
-	AVelocity.Yaw = Val;
+	GetState().AVelocity.Z = FMath::DegreesToRadians(Val);
 }
 
 float UFloatComponent::GetYawVelocity()
 {
-	return AVelocity.Yaw;
+	return FMath::RadiansToDegrees(GetState().AVelocity.Z);
 }
 
 // Estimate moving average of drag affecting the float
 float UFloatComponent::GetCurrentDrag()
 {
-	return CurrentCombinedDrag;
+	return GetState().CurrentCombinedDrag;
 }
 
 // Input velocity
 void UFloatComponent::SetVelocity(FVector Val)
 {
-	Velocity = Val;
+	GetState().Velocity = Val;
 }
 
 FVector UFloatComponent::GetVelocity()
 {
-	return Velocity;
+	return GetState().Velocity;
 }
 
 bool UFloatComponent::GetIsInAir()
 {
-	return IsInAir;
+	return GetState().IsInAir;
 }
 
+// Let the float system ride this float on the waves instead of simulating it, however near it is
+void UFloatComponent::SetRideOnly(bool RideOnly)
+{
+	bRideOnly = RideOnly;
+}
+
+bool UFloatComponent::IsRideOnly()
+{
+	return bRideOnly;
+}
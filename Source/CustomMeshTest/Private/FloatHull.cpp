@@ -0,0 +1,217 @@
+// Simplified hull of a float - its triangles are clipped against the wave surface and the water pressure on the submerged parts summed into a force and torque
+
+#include "CustomMeshTest.h"
+#include "FloatHull.h"
+
+
+FFloatHull::FFloatHull()
+	: RadiusOfGyrationSquared(1.f)
+{
+}
+
+// Build a box shaped hull with the given half extents, centred on the float
+void FFloatHull::BuildBox(FVector Extent)
+{
+	//corner i is on the positive side of X, Y and Z for bits 1, 2 and 4
+	Verts.SetNumUninitialized(8);
+	for (int32 i = 0; i < 8; i++)
+	{
+		Verts[i] = FVector((i & 1) ? Extent.X : -Extent.X, (i & 2) ? Extent.Y : -Extent.Y, (i & 4) ? Extent.Z : -Extent.Z);
+	}
+
+	//two triangles per face
+	static const int32 Faces[6][4] = { { 0, 2, 3, 1 }, { 4, 5, 7, 6 }, { 0, 4, 6, 2 }, { 1, 3, 7, 5 }, { 0, 1, 5, 4 }, { 2, 6, 7, 3 } };
+	Indices.Reset();
+	for (int32 i = 0; i < 6; i++)
+	{
+		Indices.Add(Faces[i][0]);
+		Indices.Add(Faces[i][1]);
+		Indices.Add(Faces[i][2]);
+		Indices.Add(Faces[i][0]);
+		Indices.Add(Faces[i][2]);
+		Indices.Add(Faces[i][3]);
+	}
+
+	OrientTriangles();
+}
+
+// Build the hull from the first level of a static mesh, scaled into the float's space - the mesh needs CPU access to be read in cooked builds
+bool FFloatHull::BuildFromStaticMesh(UStaticMesh* Mesh, FVector Scale)
+{
+	if (!Mesh || !Mesh->RenderData || Mesh->RenderData->LODResources.Num() == 0) return false;
+
+	const FStaticMeshLODResources &LOD = Mesh->RenderData->LODResources[0];
+	TArray<uint32> MeshIndices;
+	LOD.IndexBuffer.GetCopy(MeshIndices);
+	if (MeshIndices.Num() < 3) return false;
+
+	//render verts are split along uv and normal seams, weld them back together so every corner is only sampled once
+	TMap<FVector, int32> WeldedVerts;
+	TArray<int32> VertRemap;
+	VertRemap.SetNumUninitialized(LOD.PositionVertexBuffer.GetNumVertices());
+	Verts.Reset();
+	for (int32 i = 0; i < VertRemap.Num(); i++)
+	{
+		FVector Position = LOD.PositionVertexBuffer.VertexPosition(i) * Scale;
+		int32* Existing = WeldedVerts.Find(Position);
+		if (Existing)
+		{
+			VertRemap[i] = *Existing;
+		}
+		else
+		{
+			VertRemap[i] = Verts.Add(Position);
+			WeldedVerts.Add(Position, VertRemap[i]);
+		}
+	}
+
+	Indices.SetNumUninitialized(MeshIndices.Num() - MeshIndices.Num() % 3);
+	for (int32 i = 0; i < Indices.Num(); i++)
+	{
+		Indices[i] = VertRemap[MeshIndices[i]];
+	}
+
+	OrientTriangles();
+	return true;
+}
+
+// Wind every triangle the same way, with normals facing out of the hull
+void FFloatHull::OrientTriangles()
+{
+	//a closed mesh wound outwards encloses a positive volume
+	float SignedVolume = 0.f;
+	for (int32 i = 0; i + 2 < Indices.Num(); i += 3)
+	{
+		SignedVolume += Verts[Indices[i]] | (Verts[Indices[i + 1]] ^ Verts[Indices[i + 2]]);
+	}
+	if (SignedVolume < 0.f)
+	{
+		for (int32 i = 0; i + 2 < Indices.Num(); i += 3)
+		{
+			Indices.Swap(i + 1, i + 2);
+		}
+	}
+
+	RadiusOfGyrationSquared = 0.f;
+	for (int32 i = 0; i < Verts.Num(); i++)
+	{
+		RadiusOfGyrationSquared += Verts[i].SizeSquared();
+	}
+	RadiusOfGyrationSquared = FMath::Max(RadiusOfGyrationSquared / FMath::Max(Verts.Num(), 1), 1.f);
+}
+
+bool FFloatHull::IsBuilt() const
+{
+	return Indices.Num() >= 3;
+}
+
+int32 FFloatHull::GetNumVerts() const
+{
+	return Verts.Num();
+}
+
+float FFloatHull::GetRadiusOfGyrationSquared() const
+{
+	return RadiusOfGyrationSquared;
+}
+
+// Volume under flat water with the float upright and its lowest point the given depth under the surface
+float FFloatHull::GetDisplacedVolume(float Draft) const
+{
+	float Bottom = 0.f;
+	for (int32 i = 0; i < Verts.Num(); i++)
+	{
+		Bottom = i == 0 ? Verts[i].Z : FMath::Min(Bottom, Verts[i].Z);
+	}
+
+	TArray<float> FlatWater;
+	FlatWater.Init(Bottom + Draft, Verts.Num());
+
+	//pressure on a submerged surface adds up to the volume it displaces
+	FVector Force;
+	FVector Torque;
+	ComputePressure(Verts.GetData(), FlatWater.GetData(), FVector::ZeroVector, Force, Torque);
+	return Force.Z;
+}
+
+// Add the world position of each vert, and its position on the ocean plane to sample the waves at, for a float transform
+void FFloatHull::AppendSamples(FVector Location, FQuat Rotation, TArray<FVector> &WorldVerts, TArray<FVector2D> &SamplePositions) const
+{
+	for (int32 i = 0; i < Verts.Num(); i++)
+	{
+		FVector WorldVert = Location + Rotation.RotateVector(Verts[i]);
+		WorldVerts.Add(WorldVert);
+		SamplePositions.Add(FVector2D(WorldVert.X, WorldVert.Y));
+	}
+}
+
+// Add the pressure force and torque on a fully submerged triangle given the depth of each of its corners
+void FFloatHull::AddTrianglePressure(const FVector &A, const FVector &B, const FVector &C, float DepthA, float DepthB, float DepthC, const FVector &Centre, FVector &Force, FVector &Torque)
+{
+	float DepthSum = DepthA + DepthB + DepthC;
+	if (DepthSum <= 0.f) return;
+
+	//pressure grows linearly with depth, so the mean corner depth over the triangle's area is exact - it pushes against the outward normal
+	FVector TriangleForce = ((B - A) ^ (C - A)) * (-DepthSum / 6.f);
+	Force += TriangleForce;
+
+	//applied at the centre of pressure, pulled from the centroid toward the deeper corners
+	FVector CentreOfPressure = ((A + B + C) * DepthSum + A * DepthA + B * DepthB + C * DepthC) / (4.f * DepthSum);
+	Torque += (CentreOfPressure - Centre) ^ TriangleForce;
+}
+
+// Sum the water pressure force and its torque about the centre over the submerged part of the hull, using the wave height at each vert - pressure is depth times area, returns false if no part is under water
+bool FFloatHull::ComputePressure(const FVector* WorldVerts, const float* WaveHeights, FVector Centre, FVector &Force, FVector &Torque) const
+{
+	Force = FVector::ZeroVector;
+	Torque = FVector::ZeroVector;
+	bool Submerged = false;
+
+	for (int32 i = 0; i + 2 < Indices.Num(); i += 3)
+	{
+		FVector Corners[3];
+		float Depths[3];
+		int32 NumUnder = 0;
+		for (int32 j = 0; j < 3; j++)
+		{
+			int32 Vert = Indices[i + j];
+			Corners[j] = WorldVerts[Vert];
+			Depths[j] = WaveHeights[Vert] - Corners[j].Z;
+			NumUnder += Depths[j] > 0.f ? 1 : 0;
+		}
+		if (NumUnder == 0) continue;
+
+		Submerged = true;
+		if (NumUnder == 3)
+		{
+			AddTrianglePressure(Corners[0], Corners[1], Corners[2], Depths[0], Depths[1], Depths[2], Centre, Force, Torque);
+			continue;
+		}
+
+		//clip the triangle at the waterline, leaving a triangle or a quad under the water
+		FVector Clipped[4];
+		float ClippedDepths[4];
+		int32 NumClipped = 0;
+		for (int32 j = 0; j < 3; j++)
+		{
+			int32 k = (j + 1) % 3;
+			if (Depths[j] > 0.f)
+			{
+				Clipped[NumClipped] = Corners[j];
+				ClippedDepths[NumClipped++] = Depths[j];
+			}
+			if ((Depths[j] > 0.f) != (Depths[k] > 0.f))
+			{
+				Clipped[NumClipped] = FMath::Lerp(Corners[j], Corners[k], Depths[j] / (Depths[j] - Depths[k]));
+				ClippedDepths[NumClipped++] = 0.f;
+			}
+		}
+
+		for (int32 j = 2; j < NumClipped; j++)
+		{
+			AddTrianglePressure(Clipped[0], Clipped[j - 1], Clipped[j], ClippedDepths[0], ClippedDepths[j - 1], ClippedDepths[j], Centre, Force, Torque);
+		}
+	}
+
+	return Submerged;
+}
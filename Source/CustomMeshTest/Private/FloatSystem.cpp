@@ -0,0 +1,454 @@
+// Steps every float in the world together - float states are kept side by side, the waves are sampled for all of them in one batch and each owner's transform is written once per frame
+
+#include "CustomMeshTest.h"
+#include "CustomMeshTestGameMode.h"
+#include "WaveManager.h"
+#include "FloatComponent.h"
+#include "OceanSpatialHash.h"
+#include "Async/ParallelFor.h"
+#include "FloatSystem.h"
+
+
+// Sets default values
+AFloatSystem::AFloatSystem()
+{
+ 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
+	PrimaryActorTick.bCanEverTick = true;
+
+	//default step params
+	StepRate = 60.f;
+	MaxSubsteps = 4;
+	StepAccumulator = 0.f;
+
+	//default riding params
+	bRideDistantFloats = true;
+	RideDistance = 8000.f;
+	RideHiddenDistance = 3000.f;
+	RideHiddenTime = 1.f;
+	RideHysteresis = 1000.f;
+	RideTickInterval = 0.25f;
+	WakeBlendTime = 0.5f;
+
+	//default parallel params
+	bParallelIntegrate = true;
+	ParallelMinFloats = 64;
+
+	//default contact params
+	bFloatContacts = true;
+	ContactIterations = 2;
+	ContactCorrection = 0.8f;
+	ContactSlop = 1.f;
+	ContactMargin = 50.f;
+
+	//default hull timing params
+	HullPassBudgetMs = 2.f;
+	HullPassOverBudget = false;
+
+	SpatialHash = nullptr;
+}
+
+// Called every frame
+void AFloatSystem::Tick( float DeltaTime )
+{
+	Super::Tick( DeltaTime );
+
+	//waves, time and player for this frame
+	const FOceanContext* Ocean = ACustomMeshTestGameMode::FindOceanContext(this);
+	WaveManager = Ocean ? Ocean->WaveManager : nullptr;
+	if (!WaveManager || Floats.Num() == 0) return;
+
+	float Time = Ocean->Time;
+
+	SpatialHash = Ocean->SpatialHash;
+
+	UpdateRiding(*Ocean);
+	RideFloatsOnWaves(DeltaTime, Time);
+	FindContactPairs(DeltaTime);
+
+	//fixed length steps shared by every float, same catch up limit as a single float
+	float StepTime = 1.f / FMath::Max(StepRate, 1.f);
+	StepAccumulator += DeltaTime;
+
+	int32 NumSteps = FMath::FloorToInt(StepAccumulator / StepTime);
+	if (NumSteps > FMath::Max(MaxSubsteps, 1))
+	{
+		NumSteps = FMath::Max(MaxSubsteps, 1);
+		StepAccumulator = StepTime * NumSteps;
+	}
+
+	for (int32 i = 0; i < NumSteps; i++)
+	{
+		StepAccumulator -= StepTime;
+		StepFloats(StepTime, Time - StepAccumulator);
+	}
+
+	ApplyInterpolatedTransforms(StepAccumulator / StepTime, DeltaTime);
+}
+
+// Advance every float by one step, sampling the waves for all of them at once
+void AFloatSystem::StepFloats(float StepTime, float Time)
+{
+	int32 NumFloats = ActiveFloats.Num();
+	if (NumFloats == 0) return;
+
+	//one wave batch for every simulated float's location
+	SamplePositions.SetNumUninitialized(NumFloats);
+	for (int32 i = 0; i < NumFloats; i++)
+	{
+		int32 Float = ActiveFloats[i];
+		PreviousStates[Float] = States[Float];
+		SamplePositions[i] = FVector2D(States[Float].Location.X, States[Float].Location.Y);
+	}
+
+	WaveManager->GetWaveDisplacementNormalBatch(SamplePositions, Time, WaveDisplacements, WaveNormals);
+
+	//one height batch for the verts of every hull, waves move sideways so each vert needs the height of the surface that ends up under it
+	double HullPassStart = FPlatformTime::Seconds();
+	HullStarts.SetNumUninitialized(NumFloats);
+	HullWorldVerts.Reset();
+	HullSamplePositions.Reset();
+	for (int32 i = 0; i < NumFloats; i++)
+	{
+		int32 Float = ActiveFloats[i];
+		HullStarts[i] = INDEX_NONE;
+		if (Floats[Float]->HasHull())
+		{
+			HullStarts[i] = HullWorldVerts.Num();
+			Floats[Float]->AppendHullSamples(States[Float], HullWorldVerts, HullSamplePositions);
+		}
+	}
+	if (HullSamplePositions.Num() > 0)
+	{
+		WaveManager->GetWaveHeightNormalBatch(HullSamplePositions, Time, HullHeights, HullNormals);
+	}
+
+	//warn once if gathering and sampling the hulls goes over budget
+	float HullPassMs = (FPlatformTime::Seconds() - HullPassStart) * 1000.0;
+	if (HullPassMs > HullPassBudgetMs && !HullPassOverBudget)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Float hull pass took %.2f ms for %d hull verts, over %.2f ms budget."), HullPassMs, HullSamplePositions.Num(), HullPassBudgetMs);
+		HullPassOverBudget = true;
+	}
+
+	//each float only writes its own state, so they can be integrated on any thread
+	auto Integrate = [&](int32 i)
+	{
+		int32 Float = ActiveFloats[i];
+		int32 HullStart = HullStarts[i];
+		const FVector* HullVerts = HullStart != INDEX_NONE ? &HullWorldVerts[HullStart] : nullptr;
+		const float* HullVertHeights = HullStart != INDEX_NONE ? &HullHeights[HullStart] : nullptr;
+		Floats[Float]->IntegrateFloat(States[Float], StepTime, WaveDisplacements[i], WaveNormals[i], HullVerts, HullVertHeights);
+	};
+
+	if (bParallelIntegrate && NumFloats >= ParallelMinFloats)
+	{
+		ParallelFor(NumFloats, Integrate);
+	}
+	else
+	{
+		for (int32 i = 0; i < NumFloats; i++)
+		{
+			Integrate(i);
+		}
+	}
+
+	ResolveContacts();
+}
+
+// Move every float's owner to its state between the previous and latest step
+void AFloatSystem::ApplyInterpolatedTransforms(float Alpha, float DeltaTime)
+{
+	for (int32 j = 0; j < ActiveFloats.Num(); j++)
+	{
+		int32 i = ActiveFloats[j];
+		FVector Location = FMath::Lerp(PreviousStates[i].Location, States[i].Location, Alpha);
+		FQuat Rotation = FQuat::Slerp(PreviousStates[i].Rotation, States[i].Rotation, Alpha);
+
+		//just woken floats ease from where they were riding so there's no visible jump
+		if (BlendAlphas[i] < 1.f)
+		{
+			BlendAlphas[i] = WakeBlendTime > 0.f ? FMath::Min(BlendAlphas[i] + DeltaTime / WakeBlendTime, 1.f) : 1.f;
+			float Blend = FMath::SmoothStep(0.f, 1.f, BlendAlphas[i]);
+			Location = FMath::Lerp(BlendFrom[i].GetLocation(), Location, Blend);
+			Rotation = FQuat::Slerp(BlendFrom[i].GetRotation(), Rotation, Blend);
+		}
+
+		//one transform update for both
+		Floats[i]->GetOwner()->SetActorLocationAndRotation(Location, Rotation);
+
+		if (SpatialHash)
+		{
+			SpatialHash->MoveActor(Floats[i]->GetOwner(), Location);
+		}
+	}
+}
+
+// Switch floats between riding and simulation by distance from the player and whether they're being seen
+void AFloatSystem::UpdateRiding(const FOceanContext& Ocean)
+{
+	ActiveFloats.Reset();
+
+	bool CanRide = bRideDistantFloats && Ocean.PlayerPawn;
+
+	for (int32 i = 0; i < Floats.Num(); i++)
+	{
+		AActor* Owner = Floats[i]->GetOwner();
+		bool ShouldRide = false;
+		if (Floats[i]->IsRideOnly() && Owner != Ocean.PlayerPawn)
+		{
+			//not significant enough to simulate wherever it is
+			ShouldRide = true;
+		}
+		else if (CanRide && Owner != Ocean.PlayerPawn)
+		{
+			//riding floats need to come a little closer to wake, so floats on the boundary don't flicker between modes
+			float Margin = Riding[i] ? RideHysteresis : 0.f;
+			float Distance = FVector::Dist(States[i].Location, Ocean.PlayerLocation);
+			bool Hidden = Ocean.Time - Owner->GetLastRenderTime() > RideHiddenTime;
+			ShouldRide = Distance > RideDistance - Margin || (Hidden && Distance > RideHiddenDistance - Margin);
+		}
+
+		if (ShouldRide && !Riding[i])
+		{
+			//stagger updates so riders don't all land on the same frame
+			Riding[i] = true;
+			RideTimers[i] = FMath::FRand() * RideTickInterval;
+		}
+		else if (!ShouldRide && Riding[i])
+		{
+			//wake at rest on the surface where it was riding, shown from its riding pose
+			Riding[i] = false;
+			States[i].Velocity = FVector::ZeroVector;
+			States[i].AVelocity.X = 0.f;
+			States[i].AVelocity.Y = 0.f;
+			States[i].IsInAir = false;
+			PreviousStates[i] = States[i];
+			BlendFrom[i] = Owner->GetActorTransform();
+			BlendAlphas[i] = 0.f;
+		}
+
+		if (!Riding[i])
+		{
+			ActiveFloats.Add(i);
+		}
+	}
+}
+
+// Place riding floats that are due an update straight onto the wave surface
+void AFloatSystem::RideFloatsOnWaves(float DeltaTime, float Time)
+{
+	RideFloats.Reset();
+	for (int32 i = 0; i < Floats.Num(); i++)
+	{
+		if (!Riding[i]) continue;
+
+		RideTimers[i] += DeltaTime;
+		if (RideTimers[i] >= RideTickInterval)
+		{
+			RideTimers[i] -= RideTickInterval;
+			RideFloats.Add(i);
+		}
+	}
+	if (RideFloats.Num() == 0) return;
+
+	//one wave batch for every rider due this frame, at the undisplaced point it floats on
+	SamplePositions.SetNumUninitialized(RideFloats.Num());
+	for (int32 j = 0; j < RideFloats.Num(); j++)
+	{
+		FFloatState &State = States[RideFloats[j]];
+		SamplePositions[j] = FVector2D(State.PositionOnOcean.X, State.PositionOnOcean.Y);
+	}
+	WaveManager->GetWaveDisplacementNormalBatch(SamplePositions, Time, WaveDisplacements, WaveNormals);
+
+	for (int32 j = 0; j < RideFloats.Num(); j++)
+	{
+		int32 i = RideFloats[j];
+		FFloatState &State = States[i];
+
+		//where the simulation would settle - on the surface and lying along its normal, yaw kept
+		State.Location = State.PositionOnOcean + WaveDisplacements[j];
+		FVector Forward = State.Rotation.GetAxisX();
+		State.Rotation = FRotationMatrix::MakeFromZX(WaveNormals[j], Forward).ToQuat();
+		PreviousStates[i] = State;
+
+		Floats[i]->GetOwner()->SetActorLocationAndRotation(State.Location, State.Rotation);
+
+		if (SpatialHash)
+		{
+			SpatialHash->MoveActor(Floats[i]->GetOwner(), State.Location);
+		}
+	}
+}
+
+// Find pairs of floats that could touch during this frame's steps by looking around each simulated float in the spatial hash
+void AFloatSystem::FindContactPairs(float DeltaTime)
+{
+	ContactPairs.Reset();
+	if (!bFloatContacts || !SpatialHash) return;
+
+	//look far enough to reach any shape, allowing for how far floats move before the frame's last step
+	float MaxReach = 0.f;
+	float MaxSpeed = 0.f;
+	for (int32 i = 0; i < Floats.Num(); i++)
+	{
+		if (!Floats[i]->HasContactShape()) continue;
+
+		MaxReach = FMath::Max(MaxReach, Floats[i]->GetContactReach());
+		if (!Riding[i])
+		{
+			MaxSpeed = FMath::Max(MaxSpeed, States[i].Velocity.Size2D());
+		}
+	}
+	float Margin = ContactMargin + 2.f * MaxSpeed * DeltaTime;
+
+	int32 KindMask = AOceanSpatialHash::GetKindMask(EOceanSpatialKind::OSK_Float) | AOceanSpatialHash::GetKindMask(EOceanSpatialKind::OSK_Vessel);
+	for (int32 j = 0; j < ActiveFloats.Num(); j++)
+	{
+		int32 i = ActiveFloats[j];
+		if (!Floats[i]->HasContactShape()) continue;
+
+		SpatialHash->QueryRadius(States[i].Location, Floats[i]->GetContactReach() + MaxReach + Margin, KindMask, ContactNeighbours);
+		for (int32 k = 0; k < ContactNeighbours.Num(); k++)
+		{
+			const int32* Other = OwnerIndices.Find(ContactNeighbours[k]);
+			if (!Other || *Other == i || !Floats[*Other]->HasContactShape()) continue;
+
+			//pairs of simulated floats are found from both sides, keep one
+			if (!Riding[*Other] && *Other < i) continue;
+
+			ContactPairs.Add(FIntPoint(i, *Other));
+		}
+	}
+}
+
+// Push touching floats apart on the ocean plane and bounce them off each other, riding floats don't move
+void AFloatSystem::ResolveContacts()
+{
+	for (int32 Iteration = 0; Iteration < ContactIterations; Iteration++)
+	{
+		for (int32 p = 0; p < ContactPairs.Num(); p++)
+		{
+			int32 A = ContactPairs[p].X;
+			int32 B = ContactPairs[p].Y;
+			FFloatState &StateA = States[A];
+			FFloatState &StateB = States[B];
+			UFloatComponent* FloatA = Floats[A];
+			UFloatComponent* FloatB = Floats[B];
+
+			//closest points of the two shapes' core segments
+			FVector StartA, EndA, StartB, EndB, PointA, PointB;
+			FloatA->GetContactSegment(StateA, StartA, EndA);
+			FloatB->GetContactSegment(StateB, StartB, EndB);
+			FMath::SegmentDistToSegmentSafe(StartA, EndA, StartB, EndB, PointA, PointB);
+
+			FVector Delta = PointB - PointA;
+			float Distance = Delta.Size();
+			float Penetration = FloatA->ContactRadius + FloatB->ContactRadius - Distance;
+			if (Penetration <= 0.f) continue;
+
+			//shapes right on top of each other are pushed apart along the line between their centres
+			FVector CentreA = FVector(StateA.Location.X, StateA.Location.Y, 0.f);
+			FVector CentreB = FVector(StateB.Location.X, StateB.Location.Y, 0.f);
+			FVector Normal = Distance > KINDA_SMALL_NUMBER ? Delta / Distance : (CentreB - CentreA).GetSafeNormal();
+			if (Normal.IsZero())
+			{
+				Normal = FVector(1.f, 0.f, 0.f);
+			}
+
+			float InvMassA, InvInertiaA, InvMassB, InvInertiaB;
+			FloatA->GetContactInverseMass(InvMassA, InvInertiaA);
+			FloatB->GetContactInverseMass(InvMassB, InvInertiaB);
+			if (Riding[B])
+			{
+				InvMassB = 0.f;
+				InvInertiaB = 0.f;
+			}
+			float InvMassSum = InvMassA + InvMassB;
+
+			//move both out of the overlap, the lighter float further
+			FVector Push = Normal * (FMath::Max(Penetration - ContactSlop, 0.f) * ContactCorrection / InvMassSum);
+			StateA.PositionOnOcean -= Push * InvMassA;
+			StateA.Location -= Push * InvMassA;
+			StateB.PositionOnOcean += Push * InvMassB;
+			StateB.Location += Push * InvMassB;
+
+			//velocity of each float at the contact point, including its yaw spin
+			FVector Contact = (PointA + Normal * FloatA->ContactRadius + PointB - Normal * FloatB->ContactRadius) * 0.5f;
+			FVector ArmA = Contact - CentreA;
+			FVector ArmB = Contact - CentreB;
+			FVector ContactVelocityA = FVector(StateA.Velocity.X - StateA.AVelocity.Z * ArmA.Y, StateA.Velocity.Y + StateA.AVelocity.Z * ArmA.X, 0.f);
+			FVector ContactVelocityB = FVector(StateB.Velocity.X - StateB.AVelocity.Z * ArmB.Y, StateB.Velocity.Y + StateB.AVelocity.Z * ArmB.X, 0.f);
+
+			float ClosingSpeed = (ContactVelocityB - ContactVelocityA) | Normal;
+			if (ClosingSpeed >= 0.f) continue;
+
+			//impulse along the normal that stops them closing and bounces them apart, spinning each about its centre
+			float ArmNormalA = ArmA.X * Normal.Y - ArmA.Y * Normal.X;
+			float ArmNormalB = ArmB.X * Normal.Y - ArmB.Y * Normal.X;
+			float Restitution = FMath::Max(FloatA->ContactRestitution, FloatB->ContactRestitution);
+			float Impulse = -(1.f + Restitution) * ClosingSpeed / (InvMassSum + ArmNormalA * ArmNormalA * InvInertiaA + ArmNormalB * ArmNormalB * InvInertiaB);
+
+			StateA.Velocity -= Normal * (Impulse * InvMassA);
+			StateA.AVelocity.Z -= ArmNormalA * Impulse * InvInertiaA;
+			StateB.Velocity += Normal * (Impulse * InvMassB);
+			StateB.AVelocity.Z += ArmNormalB * Impulse * InvInertiaB;
+		}
+	}
+}
+
+// Number of floats currently riding the waves instead of being simulated
+int32 AFloatSystem::GetNumRidingFloats()
+{
+	int32 NumRiding = 0;
+	for (int32 i = 0; i < Riding.Num(); i++)
+	{
+		NumRiding += Riding[i] ? 1 : 0;
+	}
+	return NumRiding;
+}
+
+// Start stepping a float with the rest, returns its index
+int32 AFloatSystem::RegisterFloat(UFloatComponent* Float, const FFloatState &InitialState)
+{
+	OwnerIndices.Add(Float->GetOwner(), Floats.Add(Float));
+	PreviousStates.Add(InitialState);
+	Riding.Add(false);
+	RideTimers.Add(0.f);
+	BlendAlphas.Add(1.f);
+	BlendFrom.Add(FTransform::Identity);
+	return States.Add(InitialState);
+}
+
+// Stop stepping a float, the last float takes its index
+void AFloatSystem::UnregisterFloat(UFloatComponent* Float)
+{
+	int32 Index = Floats.Find(Float);
+	if (Index == INDEX_NONE) return;
+
+	OwnerIndices.Remove(Float->GetOwner());
+	Floats.RemoveAtSwap(Index);
+	States.RemoveAtSwap(Index);
+	PreviousStates.RemoveAtSwap(Index);
+	Riding.RemoveAtSwap(Index);
+	RideTimers.RemoveAtSwap(Index);
+	BlendAlphas.RemoveAtSwap(Index);
+	BlendFrom.RemoveAtSwap(Index);
+
+	//tell the float that moved where it is now
+	if (Index < Floats.Num())
+	{
+		Floats[Index]->SetFloatSystemIndex(Index);
+		OwnerIndices.Add(Floats[Index]->GetOwner(), Index);
+	}
+}
+
+// Physics state of a registered float
+FFloatState& AFloatSystem::GetFloatState(int32 Index)
+{
+	return States[Index];
+}
+
+int32 AFloatSystem::GetNumFloats()
+{
+	return Floats.Num();
+}
@@ -0,0 +1,169 @@
+// Visual only - world aligned foam intensity map around a moving centre, splatted into and decayed on the CPU and uploaded as a texture for the ocean material
+
+#include "CustomMeshTest.h"
+#include "FoamAccumulationMap.h"
+
+
+FFoamAccumulationMap::FFoamAccumulationMap()
+	: Resolution(0)
+	, WorldSize(0.f)
+	, TexelSize(1.f)
+	, WindowOrigin(0, 0)
+	, WindowValid(false)
+{
+}
+
+// Create an empty map of the given resolution covering the given world size
+void FFoamAccumulationMap::Init(int32 NewResolution, float NewWorldSize)
+{
+	//whole number of 4 wide vectors per map for the decay pass
+	Resolution = FMath::Max(Align(NewResolution, 4), 4);
+	WorldSize = FMath::Max(NewWorldSize, 1.f);
+	TexelSize = WorldSize / Resolution;
+
+	Intensity.Init(0.f, Resolution*Resolution);
+	UploadTexels.Init(0, Resolution*Resolution);
+	WindowValid = false;
+}
+
+// Index into the map of a world texel coordinate
+int32 FFoamAccumulationMap::WrapIndex(int32 WorldTexel) const
+{
+	int32 Index = WorldTexel % Resolution;
+	return Index < 0 ? Index + Resolution : Index;
+}
+
+// Clear every texel in a column of world texels
+void FFoamAccumulationMap::ClearColumn(int32 WorldTexelX)
+{
+	int32 X = WrapIndex(WorldTexelX);
+	for (int32 Y = 0; Y < Resolution; Y++)
+	{
+		Intensity[Y*Resolution + X] = 0.f;
+	}
+}
+
+// Clear every texel in a row of world texels
+void FFoamAccumulationMap::ClearRow(int32 WorldTexelY)
+{
+	FMemory::Memzero(&Intensity[WrapIndex(WorldTexelY)*Resolution], Resolution*sizeof(float));
+}
+
+// Move the window the map covers to be centred on a location, clearing texels that scroll in
+void FFoamAccumulationMap::Recentre(FVector2D Centre)
+{
+	if (Resolution == 0) return;
+
+	FIntPoint NewOrigin(FMath::FloorToInt(Centre.X / TexelSize) - Resolution / 2, FMath::FloorToInt(Centre.Y / TexelSize) - Resolution / 2);
+	if (WindowValid && NewOrigin == WindowOrigin) return;
+
+	FIntPoint Shift = NewOrigin - WindowOrigin;
+	if (!WindowValid || FMath::Abs(Shift.X) >= Resolution || FMath::Abs(Shift.Y) >= Resolution)
+	{
+		//nothing of the old window is still covered
+		FMemory::Memzero(Intensity.GetData(), Intensity.Num()*sizeof(float));
+	}
+	else
+	{
+		//clear the strips of texels that have wrapped around from the far side
+		for (int32 i = 0; i < FMath::Abs(Shift.X); i++)
+		{
+			ClearColumn(Shift.X > 0 ? WindowOrigin.X + Resolution + i : NewOrigin.X + i);
+		}
+		for (int32 i = 0; i < FMath::Abs(Shift.Y); i++)
+		{
+			ClearRow(Shift.Y > 0 ? WindowOrigin.Y + Resolution + i : NewOrigin.Y + i);
+		}
+	}
+
+	WindowOrigin = NewOrigin;
+	WindowValid = true;
+}
+
+// Add foam in a disc with linear falloff from its centre
+void FFoamAccumulationMap::Splat(FVector2D Location, float Radius, float Amount)
+{
+	if (!WindowValid || Radius <= 0.f || Amount <= 0.f) return;
+
+	//disc bounds in world texels, clipped to the window
+	float TexelRadius = Radius / TexelSize;
+	FVector2D TexelCentre = Location / TexelSize - FVector2D(0.5f, 0.5f);
+	int32 MinX = FMath::Max(FMath::CeilToInt(TexelCentre.X - TexelRadius), WindowOrigin.X);
+	int32 MaxX = FMath::Min(FMath::FloorToInt(TexelCentre.X + TexelRadius), WindowOrigin.X + Resolution - 1);
+	int32 MinY = FMath::Max(FMath::CeilToInt(TexelCentre.Y - TexelRadius), WindowOrigin.Y);
+	int32 MaxY = FMath::Min(FMath::FloorToInt(TexelCentre.Y + TexelRadius), WindowOrigin.Y + Resolution - 1);
+
+	float InvRadiusSquared = 1.f / (TexelRadius*TexelRadius);
+	for (int32 Y = MinY; Y <= MaxY; Y++)
+	{
+		float DistY = Y - TexelCentre.Y;
+		float RowFalloff = 1.f - DistY*DistY*InvRadiusSquared;
+		if (RowFalloff <= 0.f) continue;
+
+		//span of the row inside the disc, walked across the wrapped row
+		float HalfSpan = FMath::Sqrt(RowFalloff)*TexelRadius;
+		int32 SpanMinX = FMath::Max(FMath::CeilToInt(TexelCentre.X - HalfSpan), MinX);
+		int32 SpanMaxX = FMath::Min(FMath::FloorToInt(TexelCentre.X + HalfSpan), MaxX);
+
+		float* Row = &Intensity[WrapIndex(Y)*Resolution];
+		for (int32 X = SpanMinX; X <= SpanMaxX; X++)
+		{
+			float DistX = X - TexelCentre.X;
+			float Falloff = 1.f - FMath::Sqrt((DistX*DistX + DistY*DistY)*InvRadiusSquared);
+			float &Texel = Row[WrapIndex(X)];
+			Texel = FMath::Min(Texel + Amount*FMath::Max(Falloff, 0.f), 1.f);
+		}
+	}
+}
+
+// Scale every texel's foam by the given factor
+void FFoamAccumulationMap::Decay(float Factor)
+{
+	if (Factor >= 1.f) return;
+
+	//4 texels at a time, map is always a whole number of vectors
+	VectorRegister FactorVector = VectorSetFloat1(FMath::Max(Factor, 0.f));
+	float* Texels = Intensity.GetData();
+	for (int32 i = 0; i < Intensity.Num(); i += 4)
+	{
+		VectorStore(VectorMultiply(VectorLoad(Texels + i), FactorVector), Texels + i);
+	}
+}
+
+// Foam intensity at a world location, 0 outside the window
+float FFoamAccumulationMap::GetIntensityAt(FVector2D Location) const
+{
+	if (!WindowValid) return 0.f;
+
+	int32 X = FMath::FloorToInt(Location.X / TexelSize);
+	int32 Y = FMath::FloorToInt(Location.Y / TexelSize);
+	if (X < WindowOrigin.X || X >= WindowOrigin.X + Resolution || Y < WindowOrigin.Y || Y >= WindowOrigin.Y + Resolution) return 0.f;
+
+	return Intensity[WrapIndex(Y)*Resolution + WrapIndex(X)];
+}
+
+// Pack the map into bytes ready to upload to an 8 bit texture
+const TArray<uint8>& FFoamAccumulationMap::PackTexels()
+{
+	for (int32 i = 0; i < Intensity.Num(); i++)
+	{
+		UploadTexels[i] = (uint8)(Intensity[i] * 255.f + 0.5f);
+	}
+	return UploadTexels;
+}
+
+int32 FFoamAccumulationMap::GetResolution() const
+{
+	return Resolution;
+}
+
+float FFoamAccumulationMap::GetWorldSize() const
+{
+	return WorldSize;
+}
+
+// World centre of the window the map covers
+FVector2D FFoamAccumulationMap::GetCentre() const
+{
+	return (FVector2D(WindowOrigin.X, WindowOrigin.Y) + FVector2D(Resolution, Resolution)*0.5f)*TexelSize;
+}
@@ -2,6 +2,10 @@
 
 #include "CustomMeshTest.h"
 #include "ProceduralMeshComponent.h"
+#include "FoamManager.h"
+#include "CustomMeshTestGameMode.h"
+#include "OceanSignificanceManager.h"
+#include "OceanSpatialHash.h"
 #include "FoamDecal.h"
 
 
@@ -27,6 +31,15 @@ AFoamDecal::AFoamDecal()
 	Alpha = 1.f;
 	GrowRate = 0.2f;
 	CurrentGrowth = 0.f;
+	Life = 0.f;
+	Pool = nullptr;
+	SignificanceManager = nullptr;
+	SpatialHash = nullptr;
+
+	//pooled material params
+	PushedAlpha = -1.f;
+	PushedScale = -1.f;
+	MaterialParamStep = 1.f / 255.f;
 }
 
 // Called when the game starts or when spawned
@@ -42,14 +55,55 @@ void AFoamDecal::BeginPlay()
 	//random rotation on spawn
 
 	SetActorRotation(GetActorRotation() + FRotator(0.f, FMath::RandRange(-180.f, 180.f), 0.f));
+
+	//tick by how much the decal matters to the view, pooled decals don't tick so aren't managed
+	const FOceanContext* Ocean = ACustomMeshTestGameMode::FindOceanContext(this);
+	SignificanceManager = Ocean && !Pool ? Ocean->SignificanceManager : nullptr;
+	if (SignificanceManager)
+	{
+		SignificanceManager->RegisterActor(this);
+	}
+
+	//index the patch so it can be found by location, decals already waiting in the pool are indexed once they're reused
+	SpatialHash = Ocean ? Ocean->SpatialHash : nullptr;
+	if (SpatialHash && !bHidden)
+	{
+		SpatialHash->RegisterActor(this, EOceanSpatialKind::OSK_Foam);
+	}
+
+	//pooled decals are moved and faded by the pool's batch pass instead of ticking
+	if (Pool)
+	{
+		SetActorTickEnabled(false);
+	}
+}
+
+// Called when the decal is removed from play
+void AFoamDecal::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (SignificanceManager)
+	{
+		SignificanceManager->UnregisterActor(this);
+		SignificanceManager = nullptr;
+	}
+
+	if (SpatialHash)
+	{
+		SpatialHash->UnregisterActor(this);
+		SpatialHash = nullptr;
+	}
+
+	Super::EndPlay(EndPlayReason);
 }
 
 // Called every frame
 void AFoamDecal::Tick( float DeltaTime )
 {
+	double TickStart = FPlatformTime::Seconds();
+
 	Super::Tick( DeltaTime );
 
-	//increase lifetime
+	//increase lifetime - only decals placed by themselves tick, pooled decals are run by the pool
 
 	Life += DeltaTime;
 
@@ -74,5 +128,50 @@ void AFoamDecal::Tick( float DeltaTime )
 	DynamicFoamMat->SetScalarParameterValue(FName("Alpha"), AlphaLifeCurve->GetFloatValue(Life)*Alpha);
 
 	DynamicFoamMat->SetScalarParameterValue(FName("Scale"), CurrentGrowth);
+
+	if (SignificanceManager)
+	{
+		SignificanceManager->RecordTickCost(FPlatformTime::Seconds() - TickStart);
+	}
+}
+
+// Hand this decal's life over to the given pool instead of running it itself
+void AFoamDecal::SetPool(AFoamManager* NewPool)
+{
+	Pool = NewPool;
+}
+
+// Place a pooled decal at the start of a new life
+void AFoamDecal::ResetFoam(FVector Location, float Yaw)
+{
+	SetActorLocationAndRotation(Location, FRotator(0.f, Yaw, 0.f));
+
+	//material params are pushed again on the first update
+	PushedAlpha = -1.f;
+	PushedScale = -1.f;
+
+	if (SpatialHash)
+	{
+		SpatialHash->RegisterActor(this, EOceanSpatialKind::OSK_Foam);
+	}
 }
 
+// Take the pose and material params the pool worked out for this frame and move the mesh onto the waves
+void AFoamDecal::UpdatePooledFoam(float Yaw, float Scale, float LifeAlpha)
+{
+	SetActorRotation(FRotator(0.f, Yaw, 0.f));
+
+	//material params are only pushed when they change by a visible step
+	if (DynamicFoamMat && FMath::Abs(LifeAlpha - PushedAlpha) > MaterialParamStep)
+	{
+		DynamicFoamMat->SetScalarParameterValue(FName("Alpha"), LifeAlpha);
+		PushedAlpha = LifeAlpha;
+	}
+	if (DynamicFoamMat && FMath::Abs(Scale - PushedScale) > MaterialParamStep)
+	{
+		DynamicFoamMat->SetScalarParameterValue(FName("Scale"), Scale);
+		PushedScale = Scale;
+	}
+
+	UpdateWaveMesh();
+}
@@ -0,0 +1,600 @@
+// Visual only - keeps every foam patch on the ocean in one place, simulating them together and drawing them all as a single merged mesh or as pooled decals
+
+#include "CustomMeshTest.h"
+#include "ProceduralMeshComponent.h"
+#include "WaveManager.h"
+#include "CustomMeshTestGameMode.h"
+#include "OceanSpatialHash.h"
+#include "OceanDecal.h"
+#include "FoamDecal.h"
+#include "FoamManager.h"
+
+
+// Sample the curve over its time range into a table of the given resolution
+void FFoamCurveLUT::Bake(UCurveFloat* Curve, int32 Resolution)
+{
+	Values.Reset();
+	LifeLength = 0.f;
+	if (!Curve) return;
+
+	float LifeStart, LifeEnd = 0;
+	Curve->GetTimeRange(LifeStart, LifeEnd);
+	LifeLength = LifeEnd - LifeStart;
+
+	Resolution = FMath::Max(Resolution, 2);
+	Values.SetNumUninitialized(Resolution);
+	for (int32 i = 0; i < Resolution; i++)
+	{
+		Values[i] = Curve->GetFloatValue(LifeLength*i / (Resolution - 1));
+	}
+}
+
+// Linearly interpolated curve value at a time within the life
+float FFoamCurveLUT::Sample(float Time) const
+{
+	if (Values.Num() == 0) return 0.f;
+	if (LifeLength <= 0.f) return Values[0];
+
+	float Index = FMath::Clamp(Time / LifeLength, 0.f, 1.f) * (Values.Num() - 1);
+	int32 Index0 = FMath::Min(FMath::FloorToInt(Index), Values.Num() - 2);
+	return FMath::Lerp(Values[Index0], Values[Index0 + 1], Index - Index0);
+}
+
+
+// Sets default values
+AFoamManager::AFoamManager()
+{
+ 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
+	PrimaryActorTick.bCanEverTick = true;
+
+	FAttachmentTransformRules AttachRules = FAttachmentTransformRules(EAttachmentRule::KeepRelative, false);
+
+	//root component
+
+	SceneRoot = CreateDefaultSubobject<USceneComponent>(TEXT("SceneRoot"));
+	RootComponent = SceneRoot;
+
+	//merged foam procedural mesh
+
+	FoamMesh = CreateDefaultSubobject<UProceduralMeshComponent>(TEXT("FoamMesh"));
+	FoamMesh->AttachToComponent(RootComponent, AttachRules);
+	FoamMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+
+	//find material
+
+	static ConstructorHelpers::FObjectFinder<UMaterial> FoamMatClassFinder(TEXT("/Game/Boat/Effects/Materials/FoamDecalMat"));
+	FoamMaterial = FoamMatClassFinder.Object;
+
+	//find alpha curve
+
+	static ConstructorHelpers::FObjectFinder<UCurveFloat> AlphaLifeCurveClassFinder(TEXT("/Game/Boat/Effects/FoamAlphaLifeCurve"));
+	AlphaLifeCurve = AlphaLifeCurveClassFinder.Object;
+
+	//default foam params
+
+	bMergeFoam = false;
+	FoamScaleRange = 4.f;
+	AlphaLUTResolution = 64;
+
+	//default budget and level params
+
+	MaxFoamPatches = 256;
+	MaxFoamVerts = 65536;
+	NumFoamLODs = 3;
+	FoamLODStageStep = 2;
+	FoamLODDistance = 3000.f;
+
+	//default foam map params
+
+	bFoamMap = false;
+	FoamMapResolution = 256;
+	FoamMapWorldSize = 25600.f;
+	FoamMapDecayRate = 0.4f;
+	FoamMapTexture = nullptr;
+
+	//default pool params
+
+	FoamPoolPrewarm = 32;
+	FoamPoolSize = 0;
+	FoamPoolHits = 0;
+	FoamPoolMisses = 0;
+	FoamPoolWarnSize = 0;
+
+	//default grid params - same as a single foam decal
+
+	GridCellSize = 100.f;
+	GridStage = 5;
+}
+
+// Called when the game starts or when spawned
+void AFoamManager::BeginPlay()
+{
+	Super::BeginPlay();
+
+	//bake alpha curve once so the life pass doesn't evaluate the curve for every patch
+	AlphaLUT.Bake(AlphaLifeCurve, AlphaLUTResolution);
+
+	//every patch at a level uses the same shared decal grid, coarser levels keep the same size with fewer larger cells
+	LODSections.Reset();
+	for (int32 i = 0; i < FMath::Max(NumFoamLODs, 1); i++)
+	{
+		int32 Stage = FMath::Max(GridStage - i*FoamLODStageStep, 1);
+		if (i > 0 && Stage == LODSections.Last().Stage) break;
+
+		FFoamLODSection &Section = LODSections[LODSections.AddDefaulted()];
+		Section.Stage = Stage;
+		Section.GridTopology = AOceanDecal::GetGridTopology(Stage, GridCellSize*GridStage / Stage);
+	}
+
+	//foam map texture, sampled with world aligned wrapping UVs so scrolling never moves existing texels
+	if (bFoamMap)
+	{
+		FoamMap.Init(FoamMapResolution, FoamMapWorldSize);
+		FoamMapTexture = UTexture2D::CreateTransient(FoamMap.GetResolution(), FoamMap.GetResolution(), PF_G8);
+		if (FoamMapTexture)
+		{
+			FoamMapTexture->SRGB = false;
+			FoamMapTexture->AddressX = TA_Wrap;
+			FoamMapTexture->AddressY = TA_Wrap;
+			FoamMapTexture->UpdateResource();
+		}
+		UE_LOG(LogTemp, Log, TEXT("Foam map %dx%d, %.1f cm per texel."), FoamMap.GetResolution(), FoamMap.GetResolution(), FoamMap.GetWorldSize() / FoamMap.GetResolution());
+	}
+
+	//decal actors are only needed when foam isn't merged
+	if (!bMergeFoam)
+	{
+		while (FoamPoolSize < FoamPoolPrewarm)
+		{
+			GrowFoamPool();
+		}
+	}
+}
+
+// Called when the manager is removed from the world
+void AFoamManager::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (FoamPoolSize > 0)
+	{
+		UE_LOG(LogTemp, Log, TEXT("Foam decal pool: %d decals, %d hits, %d misses."), FoamPoolSize, FoamPoolHits, FoamPoolMisses);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+// Called every frame
+void AFoamManager::Tick( float DeltaTime )
+{
+	Super::Tick( DeltaTime );
+
+	UpdateFoamLife(DeltaTime);
+	if (bMergeFoam)
+	{
+		UpdateFoamMesh();
+	}
+	else
+	{
+		UpdateFoamDecals();
+	}
+	UpdateFoamMap(DeltaTime);
+}
+
+// Add a new foam patch to the ocean
+void AFoamManager::SpawnFoam(FVector Location, float Alpha, float GrowRate, float RotateRate, AActor* Spawner)
+{
+	//keep within budget by recycling a fainter patch, or refuse the new one
+	if (FoamLocations.Num() >= MaxFoamPatches && !RecycleFoam(Alpha)) return;
+
+	//separate decal actor per patch when foam isn't merged, reused from the pool
+	AFoamDecal* NewDecal = nullptr;
+	if (!bMergeFoam)
+	{
+		NewDecal = AcquireFoamDecal(Spawner);
+		if (!NewDecal) return;
+	}
+
+	//random rotation on spawn
+	float Yaw = FMath::RandRange(-180.f, 180.f);
+	if (NewDecal)
+	{
+		NewDecal->ResetFoam(Location, Yaw);
+	}
+
+	FoamLocations.Add(Location);
+	FoamYaws.Add(Yaw);
+	FoamRotateRates.Add(RotateRate);
+	FoamLives.Add(0.f);
+	FoamGrowths.Add(0.f);
+	FoamGrowRates.Add(GrowRate);
+	FoamAlphas.Add(Alpha);
+	FoamColors.Add(FColor(0, 0, 0, 0));
+	FoamDecals.Add(NewDecal);
+
+	//pose and params set now, the batch pass may already have run this frame
+	if (NewDecal)
+	{
+		NewDecal->UpdatePooledFoam(Yaw, 0.f, AlphaLUT.Sample(0.f) * Alpha);
+	}
+}
+
+int32 AFoamManager::GetNumFoam()
+{
+	return FoamLocations.Num();
+}
+
+// Foam decal pool usage so the pool can be sized per platform
+void AFoamManager::GetFoamPoolStats(int32& Hits, int32& Misses, int32& Free, int32& Total)
+{
+	Hits = FoamPoolHits;
+	Misses = FoamPoolMisses;
+	Free = FreeFoamDecals.Num();
+	Total = FoamPoolSize;
+}
+
+// Spawn a new hidden foam decal into the pool
+void AFoamManager::GrowFoamPool()
+{
+	FTransform SpawnTransform(FRotator::ZeroRotator, GetActorLocation());
+
+	//pooled and hidden before it begins play, so it isn't managed or indexed until it is first used
+	AFoamDecal* NewFoam = GetWorld()->SpawnActorDeferred<AFoamDecal>(AFoamDecal::StaticClass(), SpawnTransform, this);
+	if (NewFoam)
+	{
+		NewFoam->SetPool(this);
+		FoamPoolSize++;
+		ReleaseFoamDecal(NewFoam);
+		NewFoam->FinishSpawning(SpawnTransform);
+	}
+}
+
+// Take a foam decal from the pool, growing the pool if it is empty
+AFoamDecal* AFoamManager::AcquireFoamDecal(AActor* Spawner)
+{
+	if (FreeFoamDecals.Num() > 0)
+	{
+		FoamPoolHits++;
+	}
+	else
+	{
+		FoamPoolMisses++;
+		GrowFoamPool();
+
+		//warn each time the pool doubles past its prewarm size, not on every miss
+		if (FoamPoolSize > FMath::Max(FoamPoolPrewarm, FoamPoolWarnSize))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Foam decal pool empty, grown to %d decals (%d hits, %d misses)."), FoamPoolSize, FoamPoolHits, FoamPoolMisses);
+			FoamPoolWarnSize = FoamPoolSize * 2;
+		}
+		if (FreeFoamDecals.Num() == 0) return nullptr;
+	}
+
+	AFoamDecal* FoamDecal = FreeFoamDecals.Pop(false);
+	FoamDecal->Instigator = Spawner ? Spawner->Instigator : nullptr;
+	FoamDecal->SetActorHiddenInGame(false);
+	return FoamDecal;
+}
+
+// Hide a foam decal at the end of its patch's life and return it to the pool
+void AFoamManager::ReleaseFoamDecal(AFoamDecal* FoamDecal)
+{
+	if (!FoamDecal) return;
+
+	FoamDecal->SetActorHiddenInGame(true);
+	FreeFoamDecals.Add(FoamDecal);
+
+	//pooled decals aren't found by location until they're reused
+	const FOceanContext* Ocean = ACustomMeshTestGameMode::FindOceanContext(this);
+	if (Ocean && Ocean->SpatialHash)
+	{
+		Ocean->SpatialHash->UnregisterActor(FoamDecal);
+	}
+}
+
+// Remove a foam patch by swapping the last patch into its place
+void AFoamManager::RemoveFoam(int32 Index)
+{
+	//decal goes back to the pool for the next patch
+	if (FoamDecals[Index])
+	{
+		ReleaseFoamDecal(FoamDecals[Index]);
+	}
+
+	FoamLocations.RemoveAtSwap(Index);
+	FoamYaws.RemoveAtSwap(Index);
+	FoamRotateRates.RemoveAtSwap(Index);
+	FoamLives.RemoveAtSwap(Index);
+	FoamGrowths.RemoveAtSwap(Index);
+	FoamGrowRates.RemoveAtSwap(Index);
+	FoamAlphas.RemoveAtSwap(Index);
+	FoamColors.RemoveAtSwap(Index);
+	FoamDecals.RemoveAtSwap(Index);
+}
+
+// Advance the life of every foam patch and remove those at the end of their life
+void AFoamManager::UpdateFoamLife(float DeltaTime)
+{
+	if (AlphaLUT.Values.Num() == 0) return;
+
+	float LifeLength = AlphaLUT.LifeLength;
+	float InvScaleRange = 255.f / FoamScaleRange;
+
+	for (int32 i = FoamLocations.Num() - 1; i >= 0; i--)
+	{
+		//increase lifetime
+		FoamLives[i] += DeltaTime;
+
+		//remove at end of life
+		if (FoamLives[i] > LifeLength)
+		{
+			RemoveFoam(i);
+			continue;
+		}
+
+		//handle lifetime changes
+		FoamYaws[i] += FoamRotateRates[i] * DeltaTime;
+		FoamGrowths[i] += FoamGrowRates[i] * DeltaTime;
+
+		//pack material params for this patch's verts
+		float Alpha = AlphaLUT.Sample(FoamLives[i]) * FoamAlphas[i];
+		FoamColors[i] = FColor(
+			(uint8)FMath::Clamp(FMath::RoundToInt(FoamGrowths[i] * InvScaleRange), 0, 255), 0, 0,
+			(uint8)FMath::Clamp(FMath::RoundToInt(Alpha * 255.f), 0, 255));
+	}
+}
+
+// Pick each foam patch's level, then pass every pooled decal its grid, pose and material params for this frame and move it onto the waves
+void AFoamManager::UpdateFoamDecals()
+{
+	if (LODSections.Num() == 0) return;
+
+	PickFoamLODs();
+
+	for (int32 i = 0; i < FoamDecals.Num(); i++)
+	{
+		AFoamDecal* FoamDecal = FoamDecals[i];
+		if (!FoamDecal || FoamDecal->IsPendingKill()) continue;
+
+		//decals over the vert budget are hidden until they fit again
+		bool Drawn = PatchLODs[i] != INDEX_NONE;
+		if (FoamDecal->bHidden == Drawn)
+		{
+			FoamDecal->SetActorHiddenInGame(!Drawn);
+		}
+		if (!Drawn) continue;
+
+		//same shared grids as the merged mesh levels
+		FoamDecal->SetGridTopology(LODSections[PatchLODs[i]].GridTopology);
+		FoamDecal->UpdatePooledFoam(FoamYaws[i], FoamGrowths[i], AlphaLUT.Sample(FoamLives[i]) * FoamAlphas[i]);
+	}
+}
+
+// Pick each foam patch's level, then update every level's mesh section
+void AFoamManager::UpdateFoamMesh()
+{
+	if (LODSections.Num() == 0 || !FoamMesh) return;
+
+	//waves and time for this frame
+	const FOceanContext* Ocean = ACustomMeshTestGameMode::FindOceanContext(this);
+	WaveManager = Ocean ? Ocean->WaveManager : nullptr;
+	if (!WaveManager) return;
+
+	PickFoamLODs();
+
+	for (int32 i = 0; i < LODSections.Num(); i++)
+	{
+		UpdateLODSection(i, Ocean->Time);
+	}
+}
+
+// Pick each foam patch's level by camera distance and vert budget, nearest patches claiming the budget first
+void AFoamManager::PickFoamLODs()
+{
+	//foam level picked by distance from the camera
+	FVector ViewLocation = GetActorLocation();
+	APlayerCameraManager* CameraManager = UGameplayStatics::GetPlayerCameraManager(this, 0);
+	if (CameraManager)
+	{
+		ViewLocation = CameraManager->GetCameraLocation();
+	}
+
+	//nearest patches claim the vert budget first
+	PatchOrder.SetNumUninitialized(FoamLocations.Num());
+	PatchDistances.SetNumUninitialized(FoamLocations.Num());
+	for (int32 i = 0; i < FoamLocations.Num(); i++)
+	{
+		PatchOrder[i] = i;
+		PatchDistances[i] = FVector::Dist(FoamLocations[i], ViewLocation);
+	}
+	const TArray<float> &Distances = PatchDistances;
+	PatchOrder.Sort([&Distances](int32 A, int32 B) { return Distances[A] < Distances[B]; });
+
+	for (int32 i = 0; i < LODSections.Num(); i++)
+	{
+		LODSections[i].Patches.Reset();
+	}
+
+	PatchLODs.SetNumUninitialized(FoamLocations.Num());
+	int32 RemainingVerts = MaxFoamVerts;
+	for (int32 i = 0; i < PatchOrder.Num(); i++)
+	{
+		int32 Patch = PatchOrder[i];
+		int32 LOD = FMath::Clamp(FMath::FloorToInt(PatchDistances[Patch] / FoamLODDistance), 0, LODSections.Num() - 1);
+
+		//drop to coarser grids when out of budget, not drawn at all if even the coarsest doesn't fit
+		while (LOD < LODSections.Num() && LODSections[LOD].GridTopology->Verts.Num() > RemainingVerts)
+		{
+			LOD++;
+		}
+		if (LOD == LODSections.Num())
+		{
+			PatchLODs[Patch] = INDEX_NONE;
+			continue;
+		}
+
+		PatchLODs[Patch] = LOD;
+		LODSections[LOD].Patches.Add(Patch);
+		RemainingVerts -= LODSections[LOD].GridTopology->Verts.Num();
+	}
+}
+
+// Move the verts of every patch drawn at one foam level onto the waves and send them to that level's mesh section
+void AFoamManager::UpdateLODSection(int32 LODIndex, float Time)
+{
+	FFoamLODSection &Section = LODSections[LODIndex];
+
+	//grow the section if there are more patches than room for them
+	if (Section.Patches.Num() > Section.Capacity)
+	{
+		Section.Capacity = FMath::Max(Section.Patches.Num(), FMath::Max(Section.Capacity * 2, 16));
+		RebuildMeshSection(LODIndex);
+	}
+	if (Section.Capacity == 0) return;
+
+	const TArray<FVector> &GridVerts = Section.GridTopology->Verts;
+	int32 NumGridVerts = GridVerts.Num();
+	FVector ActorLocation = GetActorLocation();
+
+	//every patch at this level evaluated in one pass into the merged vertex arrays
+	for (int32 i = 0; i < Section.Patches.Num(); i++)
+	{
+		int32 Patch = Section.Patches[i];
+
+		float YawSin, YawCos;
+		FMath::SinCos(&YawSin, &YawCos, FMath::DegreesToRadians(FoamYaws[Patch]));
+		FColor PatchColor = FoamColors[Patch];
+
+		for (int32 j = 0; j < NumGridVerts; j++)
+		{
+			int32 MeshVert = i * NumGridVerts + j;
+
+			//calculate absolute world location of the vert based on patch location and rotation
+			FVector VertAbsolute = FoamLocations[Patch] + FVector(GridVerts[j].X * YawCos - GridVerts[j].Y * YawSin, GridVerts[j].X * YawSin + GridVerts[j].Y * YawCos, GridVerts[j].Z);
+
+			//find the displacement and normal of the wave at this location at the current game time
+			FVector WaveDisplacement;
+			FVector WaveNormal;
+			WaveManager->GetWaveDisplacementNormal(FVector2D(VertAbsolute.X, VertAbsolute.Y), Time, WaveDisplacement, WaveNormal);
+
+			Section.Verts[MeshVert] = VertAbsolute + WaveDisplacement - ActorLocation;
+			Section.Normals[MeshVert] = WaveNormal;
+			Section.Colors[MeshVert] = PatchColor;
+		}
+	}
+
+	//unused patches collapse to a single invisible point
+	for (int32 i = Section.Patches.Num() * NumGridVerts; i < Section.Verts.Num(); i++)
+	{
+		Section.Verts[i] = FVector::ZeroVector;
+		Section.Colors[i] = FColor(0, 0, 0, 0);
+	}
+
+	//update merged mesh - UVs and tangents unchanged
+	TArray<FVector2D> UV0;
+	TArray<FProcMeshTangent> Tangents;
+	FoamMesh->UpdateMeshSection(LODIndex, Section.Verts, Section.Normals, UV0, Section.Colors, Tangents);
+}
+
+// Recreate the merged mesh section for one foam level with room for that level's capacity
+void AFoamManager::RebuildMeshSection(int32 LODIndex)
+{
+	FFoamLODSection &Section = LODSections[LODIndex];
+	const TArray<FVector> &GridVerts = Section.GridTopology->Verts;
+	const TArray<int32> &GridTris = Section.GridTopology->Tris;
+	int32 NumGridVerts = GridVerts.Num();
+
+	//one copy of the shared grid per patch
+	TArray<int32> Tris;
+	TArray<FVector2D> UV0;
+	Tris.Reserve(GridTris.Num() * Section.Capacity);
+	UV0.Reserve(NumGridVerts * Section.Capacity);
+	for (int32 i = 0; i < Section.Capacity; i++)
+	{
+		for (int32 j = 0; j < GridTris.Num(); j++)
+		{
+			Tris.Add(GridTris[j] + i * NumGridVerts);
+		}
+		UV0.Append(Section.GridTopology->UVs);
+	}
+
+	Section.Verts.SetNumZeroed(NumGridVerts * Section.Capacity);
+	Section.Normals.Init(FVector::UpVector, NumGridVerts * Section.Capacity);
+	Section.Colors.SetNumZeroed(NumGridVerts * Section.Capacity);
+
+	TArray<FProcMeshTangent> Tangents;
+	FoamMesh->CreateMeshSection(LODIndex, Section.Verts, Tris, Section.Normals, UV0, Section.Colors, Tangents, false);
+	if (FoamMaterial)
+	{
+		FoamMesh->SetMaterial(LODIndex, FoamMaterial);
+	}
+	UE_LOG(LogTemp, Log, TEXT("Foam mesh level %d resized for %d patches, %d tris in one draw."), LODIndex, Section.Capacity, Tris.Num() / 3);
+}
+
+// Make room for a new foam patch by removing the oldest patch fainter than it, false if there is none
+bool AFoamManager::RecycleFoam(float Alpha)
+{
+	int32 Oldest = INDEX_NONE;
+	uint8 NewAlpha = (uint8)FMath::Clamp(FMath::RoundToInt(Alpha * 255.f), 0, 255);
+	for (int32 i = 0; i < FoamLocations.Num(); i++)
+	{
+		if (FoamColors[i].A <= NewAlpha && (Oldest == INDEX_NONE || FoamLives[i] > FoamLives[Oldest]))
+		{
+			Oldest = i;
+		}
+	}
+	if (Oldest == INDEX_NONE) return false;
+
+	RemoveFoam(Oldest);
+	return true;
+}
+
+// Scroll the foam accumulation map with the player, decay it and upload it to its texture
+void AFoamManager::UpdateFoamMap(float DeltaTime)
+{
+	if (!bFoamMap || FoamMap.GetResolution() == 0) return;
+
+	const FOceanContext* Ocean = ACustomMeshTestGameMode::FindOceanContext(this);
+	if (Ocean && Ocean->PlayerPawn)
+	{
+		FoamMap.Recentre(FVector2D(Ocean->PlayerLocation.X, Ocean->PlayerLocation.Y));
+	}
+
+	FoamMap.Decay(FMath::Exp(-FoamMapDecayRate*DeltaTime));
+
+	//one whole texture upload per frame, cost is fixed by the resolution however much foam there is
+	if (FoamMapTexture && FoamMapTexture->Resource)
+	{
+		ENQUEUE_UNIQUE_RENDER_COMMAND_THREEPARAMETER(
+			FFoamMapUpdate,
+			FTexture2DResource*, TextureResource, (FTexture2DResource*)FoamMapTexture->Resource,
+			TArray<uint8>, Texels, FoamMap.PackTexels(),
+			int32, Resolution, FoamMap.GetResolution(),
+			{
+				FUpdateTextureRegion2D Region(0, 0, 0, 0, Resolution, Resolution);
+				RHIUpdateTexture2D(TextureResource->GetTexture2DRHI(), 0, Region, Resolution, Texels.GetData());
+			});
+	}
+}
+
+// Add foam into the foam accumulation map in a disc with falloff from its centre
+void AFoamManager::SplatFoamMap(FVector Location, float Radius, float Amount)
+{
+	if (!bFoamMap) return;
+
+	FoamMap.Splat(FVector2D(Location.X, Location.Y), Radius, Amount);
+}
+
+// Foam accumulation map intensity at a world location, 0 outside the map
+float AFoamManager::GetFoamMapIntensityAt(FVector Location)
+{
+	return FoamMap.GetIntensityAt(FVector2D(Location.X, Location.Y));
+}
+
+// Pass the foam accumulation map texture and where it lies in the world to a material
+void AFoamManager::ApplyFoamMap(UMaterialInstanceDynamic* Material)
+{
+	if (!Material || !FoamMapTexture) return;
+
+	FVector2D Centre = FoamMap.GetCentre();
+	Material->SetTextureParameterValue(FName("FoamMap"), FoamMapTexture);
+	Material->SetVectorParameterValue(FName("FoamMapBounds"), FLinearColor(Centre.X, Centre.Y, FoamMap.GetWorldSize(), 0.f));
+}
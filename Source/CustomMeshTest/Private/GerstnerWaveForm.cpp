@@ -43,7 +43,7 @@ void UGerstnerWaveForm::Init(class UWaveManager* Manager)
 void UGerstnerWaveForm::GetWaveDisplacementNormal(FVector2D Position, float Time, FVector &Displacement, FVector &Normal)
 {
 	//calculate phase of the wave
-	float wavePhase = lambda * FVector2D::DotProduct(rotatedDirection, Position) + (Time*Speed + Phase);
+	float wavePhase = GetSpatialPhase(Position) + GetTimePhase(Time);
 
 	float c = 0;
 	float s = 0;
@@ -51,9 +51,39 @@ void UGerstnerWaveForm::GetWaveDisplacementNormal(FVector2D Position, float Time
 	//calculate sin and cos of the phase
 	FMath::SinCos(&s, &c, wavePhase);
 
+	GetWaveDisplacementNormalFromPhase(c, s, Displacement, Normal);
+}
+
+// Largest vertical displacement the wave can produce
+float UGerstnerWaveForm::GetMaxHeight()
+{
+	return FMath::Abs(Amplitude);
+}
+
+// Gerstner phase is linear in position and time, so it can always be cached
+bool UGerstnerWaveForm::SupportsPhaseCache()
+{
+	return true;
+}
+
+// Find the part of the wave's phase that depends only on position
+float UGerstnerWaveForm::GetSpatialPhase(FVector2D Position)
+{
+	return lambda * FVector2D::DotProduct(rotatedDirection, Position);
+}
+
+// Find the part of the wave's phase that depends only on time
+float UGerstnerWaveForm::GetTimePhase(float Time)
+{
+	return Time*Speed + Phase;
+}
+
+// Find the wave's displacement and normal given the cos and sin of its total phase
+void UGerstnerWaveForm::GetWaveDisplacementNormalFromPhase(float CosPhase, float SinPhase, FVector &Displacement, FVector &Normal)
+{
 	//calculate gerstner wave displacement
-	Displacement = FVector(Steepness * Amplitude * rotatedDirection.X * c, Steepness * Amplitude * rotatedDirection.Y * c, Amplitude * s);
+	Displacement = FVector(Steepness * Amplitude * rotatedDirection.X * CosPhase, Steepness * Amplitude * rotatedDirection.Y * CosPhase, Amplitude * SinPhase);
 
 	//calculate gerstner wave normal
-	Normal = FVector(lambda * Amplitude * rotatedDirection.X * c, lambda * Amplitude * rotatedDirection.Y * c, lambda * Steepness * Amplitude * s);
+	Normal = FVector(lambda * Amplitude * rotatedDirection.X * CosPhase, lambda * Amplitude * rotatedDirection.Y * CosPhase, lambda * Steepness * Amplitude * SinPhase);
 }
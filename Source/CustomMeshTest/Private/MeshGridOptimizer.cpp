@@ -0,0 +1,242 @@
+// Build time optimizer for generated grid meshes - reorders triangles and verts so the GPU's post-transform vertex cache is reused as much as possible
+
+#include "CustomMeshTest.h"
+#include "MeshGridOptimizer.h"
+
+
+// Score a vert by its position in the simulated cache and how many unadded tris still use it
+float FMeshGridOptimizer::ForsythVertScore(int32 CachePosition, int32 ActiveTris)
+{
+	//no tris left to use this vert
+	if (ActiveTris == 0) return -1.f;
+
+	float Score = 0.f;
+	if (CachePosition >= 0)
+	{
+		if (CachePosition < 3)
+		{
+			//verts of the last tri added - fixed score so the next tri doesn't always reuse the same edge
+			Score = 0.75f;
+		}
+		else
+		{
+			//verts deeper in the cache score less
+			Score = FMath::Pow(1.f - (float)(CachePosition - 3) / (ForsythCacheSize - 3), 1.5f);
+		}
+	}
+
+	//boost verts with few tris left, so they get finished off rather than left as stragglers
+	Score += 2.f * FMath::Pow((float)ActiveTris, -0.5f);
+
+	return Score;
+}
+
+// Reorder tris and verts for vertex cache reuse and log the average cache miss ratio before and after, OldToNew maps each old vert index to its new index
+void FMeshGridOptimizer::Optimize(TArray<int32> &Tris, int32 NumVerts, TArray<int32> &OldToNew, const TCHAR* MeshName)
+{
+	float ACMRBefore = CalculateACMR(Tris);
+
+	OptimizeTriangleOrder(Tris, NumVerts);
+	ReorderVertsByFirstUse(Tris, NumVerts, OldToNew);
+
+	UE_LOG(LogTemp, Log, TEXT("%s grid vertex cache ACMR %.3f before reordering, %.3f after."), MeshName, ACMRBefore, CalculateACMR(Tris));
+}
+
+// Reorder tris for vertex cache reuse (Forsyth linear-speed optimizer)
+void FMeshGridOptimizer::OptimizeTriangleOrder(TArray<int32> &Tris, int32 NumVerts)
+{
+	int32 NumTris = Tris.Num() / 3;
+	if (NumTris == 0 || NumVerts == 0) return;
+
+	//build the list of tris using each vert - VertTris[VertTriStart[v]..VertTriStart[v]+VertTriCount[v]] are the unadded tris of vert v
+
+	TArray<int32> VertTriCount;
+	VertTriCount.SetNumZeroed(NumVerts);
+	for (int32 i = 0; i < Tris.Num(); i++)
+	{
+		VertTriCount[Tris[i]]++;
+	}
+
+	TArray<int32> VertTriStart;
+	VertTriStart.SetNumUninitialized(NumVerts);
+	int32 TotalTriRefs = 0;
+	for (int32 i = 0; i < NumVerts; i++)
+	{
+		VertTriStart[i] = TotalTriRefs;
+		TotalTriRefs += VertTriCount[i];
+	}
+
+	TArray<int32> VertTris;
+	VertTris.SetNumUninitialized(TotalTriRefs);
+	TArray<int32> VertTriFill = VertTriStart;
+	for (int32 i = 0; i < Tris.Num(); i++)
+	{
+		VertTris[VertTriFill[Tris[i]]++] = i / 3;
+	}
+
+	//initial scores
+
+	TArray<int32> VertCachePosition;
+	VertCachePosition.Init(-1, NumVerts);
+
+	TArray<float> VertScore;
+	VertScore.SetNumUninitialized(NumVerts);
+	for (int32 i = 0; i < NumVerts; i++)
+	{
+		VertScore[i] = ForsythVertScore(-1, VertTriCount[i]);
+	}
+
+	TArray<float> TriScore;
+	TriScore.SetNumUninitialized(NumTris);
+	TArray<bool> TriAdded;
+	TriAdded.Init(false, NumTris);
+
+	int32 BestTri = -1;
+	float BestScore = -1.f;
+	for (int32 i = 0; i < NumTris; i++)
+	{
+		TriScore[i] = VertScore[Tris[i * 3]] + VertScore[Tris[i * 3 + 1]] + VertScore[Tris[i * 3 + 2]];
+		if (TriScore[i] > BestScore)
+		{
+			BestScore = TriScore[i];
+			BestTri = i;
+		}
+	}
+
+	//add tris one at a time, always picking the best scoring tri touching the simulated cache
+
+	TArray<int32> NewTris;
+	NewTris.Reserve(Tris.Num());
+
+	TArray<int32> Cache;
+	Cache.Reserve(ForsythCacheSize + 3);
+
+	int32 ScanCursor = 0;
+
+	while (NewTris.Num() < Tris.Num())
+	{
+		if (BestTri < 0)
+		{
+			//nothing in the cache has tris left - carry on from the next unadded tri
+			while (TriAdded[ScanCursor]) ScanCursor++;
+			BestTri = ScanCursor;
+		}
+
+		TriAdded[BestTri] = true;
+
+		for (int32 i = 0; i < 3; i++)
+		{
+			int32 Vert = Tris[BestTri * 3 + i];
+			NewTris.Add(Vert);
+
+			//remove tri from the vert's unadded tris
+			int32 Start = VertTriStart[Vert];
+			for (int32 j = Start; j < Start + VertTriCount[Vert]; j++)
+			{
+				if (VertTris[j] == BestTri)
+				{
+					VertTris[j] = VertTris[Start + VertTriCount[Vert] - 1];
+					VertTriCount[Vert]--;
+					break;
+				}
+			}
+		}
+
+		//move tri verts to the front of the LRU cache
+		for (int32 i = 2; i >= 0; i--)
+		{
+			int32 Vert = Tris[BestTri * 3 + i];
+			Cache.Remove(Vert);
+			Cache.Insert(Vert, 0);
+		}
+
+		//rescore every vert in the cache (and any just pushed out of it), and the tris that use them
+		for (int32 i = 0; i < Cache.Num(); i++)
+		{
+			int32 Vert = Cache[i];
+			VertCachePosition[Vert] = (i < ForsythCacheSize) ? i : -1;
+
+			float NewScore = ForsythVertScore(VertCachePosition[Vert], VertTriCount[Vert]);
+			float ScoreChange = NewScore - VertScore[Vert];
+			VertScore[Vert] = NewScore;
+
+			int32 Start = VertTriStart[Vert];
+			for (int32 j = Start; j < Start + VertTriCount[Vert]; j++)
+			{
+				TriScore[VertTris[j]] += ScoreChange;
+			}
+		}
+		if (Cache.Num() > ForsythCacheSize)
+		{
+			Cache.SetNum(ForsythCacheSize);
+		}
+
+		//pick the next tri from those touching the cache
+		BestTri = -1;
+		BestScore = -1.f;
+		for (int32 i = 0; i < Cache.Num(); i++)
+		{
+			int32 Start = VertTriStart[Cache[i]];
+			for (int32 j = Start; j < Start + VertTriCount[Cache[i]]; j++)
+			{
+				if (TriScore[VertTris[j]] > BestScore)
+				{
+					BestScore = TriScore[VertTris[j]];
+					BestTri = VertTris[j];
+				}
+			}
+		}
+	}
+
+	Tris = NewTris;
+}
+
+// Renumber verts in order of first use by the tris, so vertex fetch follows the index buffer
+void FMeshGridOptimizer::ReorderVertsByFirstUse(TArray<int32> &Tris, int32 NumVerts, TArray<int32> &OldToNew)
+{
+	OldToNew.Init(INDEX_NONE, NumVerts);
+
+	int32 NextVert = 0;
+	for (int32 i = 0; i < Tris.Num(); i++)
+	{
+		if (OldToNew[Tris[i]] == INDEX_NONE)
+		{
+			OldToNew[Tris[i]] = NextVert++;
+		}
+		Tris[i] = OldToNew[Tris[i]];
+	}
+
+	//verts not used by any tri go on the end
+	for (int32 i = 0; i < NumVerts; i++)
+	{
+		if (OldToNew[i] == INDEX_NONE)
+		{
+			OldToNew[i] = NextVert++;
+		}
+	}
+}
+
+// Average cache miss ratio (transformed verts per tri) of the tris through a FIFO vertex cache
+float FMeshGridOptimizer::CalculateACMR(const TArray<int32> &Tris, int32 CacheSize)
+{
+	if (Tris.Num() < 3) return 0.f;
+
+	TArray<int32> Cache;
+	Cache.Reserve(CacheSize + 1);
+
+	int32 Misses = 0;
+	for (int32 i = 0; i < Tris.Num(); i++)
+	{
+		if (!Cache.Contains(Tris[i]))
+		{
+			Misses++;
+			Cache.Add(Tris[i]);
+			if (Cache.Num() > CacheSize)
+			{
+				Cache.RemoveAt(0);
+			}
+		}
+	}
+
+	return (float)Misses / (Tris.Num() / 3);
+}
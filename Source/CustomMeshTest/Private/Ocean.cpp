@@ -2,8 +2,11 @@
 
 #include "CustomMeshTest.h"
 #include "ProceduralMeshComponent.h"
+#include "OceanMeshComponent.h"
 #include "WaveManager.h"
 #include "CustomMeshTestGameMode.h"
+#include "MeshGridOptimizer.h"
+#include "FoamManager.h"
 #include "Ocean.h"
 
 
@@ -25,14 +28,21 @@ AOcean::AOcean()
 
 	OceanMesh = CreateDefaultSubobject<UProceduralMeshComponent>(TEXT("GeneratedMesh"));
 	OceanMesh->AttachToComponent(RootComponent, AttachRules);
-	OceanMesh->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
-	OceanMesh->SetCollisionObjectType(ECollisionChannel::ECC_WorldDynamic);
-	OceanMesh->SetCollisionResponseToChannel(ECollisionChannel::ECC_Visibility, ECollisionResponse::ECR_Block);
+	//no collision - mesh is rewritten every frame, traces against the ocean use UWaveManager::LineTraceWaves instead
+	OceanMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+
+	//compact ocean mesh - only used with compact vertex stream
+
+	CompactOceanMesh = CreateDefaultSubobject<UOceanMeshComponent>(TEXT("CompactMesh"));
+	CompactOceanMesh->AttachToComponent(RootComponent, AttachRules);
 
 	//find ocean material
 
 	static ConstructorHelpers::FObjectFinder<UMaterial> OceanMatClassFinder(TEXT("/Game/Ocean/Materials/TestOceanMat"));
 	WaveMaterial = OceanMatClassFinder.Object;
+	bUseFoamMap = false;
+	DynamicWaveMat = nullptr;
+	FoamManager = nullptr;
 
 	//find grid expansion curve
 
@@ -47,6 +57,32 @@ AOcean::AOcean()
 	GridXOffset = -1000.f;
 	GridBuilt = false;
 	GridUVSize = 1000;
+
+	//default grid fitting params
+
+	bAutoFitGrid = false;
+	TargetPixelsPerTriangle = 600.f;
+	FitMaxDistance = 150000.f;
+	FitFOVMargin = 1.15f;
+
+	//default compact vertex stream params
+
+	bCompactVertexStream = false;
+	CompactVertexMargin = 2000.f;
+	CompactStreamBuilt = false;
+
+	//default snapping params
+
+	bSnapToLattice = false;
+	LatticeSnapSize = 400.f;
+	LatticeSnapYaw = 10.f;
+
+	//default phase cache params
+
+	bCachePhase = false;
+	PhaseCacheMaxMegabytes = 16.f;
+	PhaseCacheValid = false;
+	PhaseCacheOverBudget = false;
 }
 
 // Called when the game starts or when spawned
@@ -61,21 +97,29 @@ void AOcean::BeginPlay()
 void AOcean::Tick( float DeltaTime )
 {
 	Super::Tick( DeltaTime );
-	if (GridBuilt && OceanMesh)
+
+	//refit grid to the view if it has changed (e.g. device rotation)
+	if (bAutoFitGrid)
+	{
+		UpdateGridFit();
+	}
+
+	//waves, time and foam manager for this frame
+	const FOceanContext* Ocean = ACustomMeshTestGameMode::FindOceanContext(this);
+
+	//pass the foam map's texture and window on to the ocean material
+	if (DynamicWaveMat)
 	{
-		//get game wave manager
-		if (!WaveManager)
+		FoamManager = Ocean ? Ocean->FoamManager : nullptr;
+		if (FoamManager)
 		{
-			AGameMode* GameMode = UGameplayStatics::GetGameMode(this);
-			if (GameMode)
-			{
-				ACustomMeshTestGameMode* CustomGameMode = Cast<ACustomMeshTestGameMode>(GameMode);
-				if (CustomGameMode)
-				{
-					WaveManager = CustomGameMode->GetWaveManager();
-				}
-			}
+			FoamManager->ApplyFoamMap(DynamicWaveMat);
 		}
+	}
+
+	if (GridBuilt && OceanMesh)
+	{
+		WaveManager = Ocean ? Ocean->WaveManager : nullptr;
 		if (WaveManager)
 		{
 			//declare mesh arrays
@@ -85,33 +129,218 @@ void AOcean::Tick( float DeltaTime )
 			TArray<FVector2D> UV0;
 			TArray<FColor> VertCols;
 
+			FVector ActorLocation = GetActorLocation();
+			FRotator ActorRotation = GetActorRotation();
+			float Time = Ocean->Time;
+
+			//use cached spatial phase if possible, so only the time phase needs any trig this frame
+			bool UseCache = UpdatePhaseCache();
+			int32 NumWaves = WaveManager->GetNumWaveForms();
+			if (UseCache)
+			{
+				WaveManager->GetTimePhase(Time, TimePhase);
+			}
+
+			//compact vertex stream is written directly in its final form, otherwise verts go through the procedural mesh arrays
+			TArray<FOceanCompactVertex>* CompactVerts = CompactStreamBuilt ? &CompactOceanMesh->GetVertsForWrite() : nullptr;
+			float InvQuantizationExtent = CompactStreamBuilt ? CompactOceanMesh->GetInvQuantizationExtent() : 0.f;
+
 			//for every vert
 			for (int32 i = 0; i < GridVerts.Num(); i++)
 			{
-				//calculate absolute world location of the vert based on grid
-				FVector VertAbsolute = GetActorLocation() + GetActorRotation().RotateVector(GridVerts[i]);
-
 				//find the displacement and normal of the wave at this location at the current game time
 				FVector WaveDisplacement;
 				FVector WaveNormal;
-				WaveManager->GetWaveDisplacementNormal(FVector2D(VertAbsolute.X, VertAbsolute.Y), GetWorld()->GetTimeSeconds(), WaveDisplacement, WaveNormal);
+				if (UseCache)
+				{
+					WaveManager->GetWaveDisplacementNormalCached(&PhaseCache[i * NumWaves], TimePhase, WaveDisplacement, WaveNormal);
+				}
+				else
+				{
+					//calculate absolute world location of the vert based on grid
+					FVector VertAbsolute = ActorLocation + ActorRotation.RotateVector(GridVerts[i]);
+
+					WaveManager->GetWaveDisplacementNormal(FVector2D(VertAbsolute.X, VertAbsolute.Y), Time, WaveDisplacement, WaveNormal);
+				}
 
 				//calculate the relative location and normal of the vert to the ocean actor
-				FVector VertAbsoluteDisplacement = VertAbsolute + WaveDisplacement;
-				FVector VertRelativeDisplacement = GetActorRotation().UnrotateVector(VertAbsoluteDisplacement - GetActorLocation());
-				FVector VertRelativeNormal = GetActorRotation().UnrotateVector(WaveNormal);
-
-				//add vert data to be used by procedurally generated ocean mesh
-				Verts.Add(VertRelativeDisplacement);
-				Normals.Add(VertRelativeNormal);
-				Tangents.Add(FProcMeshTangent());
+				FVector VertRelativeDisplacement = GridVerts[i] + ActorRotation.UnrotateVector(WaveDisplacement);
+				FVector VertRelativeNormal = ActorRotation.UnrotateVector(WaveNormal);
+
+				if (CompactVerts)
+				{
+					//quantize vert data straight into the compact stream
+					(*CompactVerts)[i].Set(VertRelativeDisplacement, VertRelativeNormal.GetSafeNormal(), InvQuantizationExtent);
+				}
+				else
+				{
+					//add vert data to be used by procedurally generated ocean mesh
+					Verts.Add(VertRelativeDisplacement);
+					Normals.Add(VertRelativeNormal);
+					Tangents.Add(FProcMeshTangent());
+				}
+			}
+			if (CompactVerts)
+			{
+				//update compact ocean mesh
+				CompactOceanMesh->UpdateMesh();
+			}
+			else
+			{
+				//update procedurally generated ocean mesh
+				OceanMesh->UpdateMeshSection(0, Verts, Normals, UV0, VertCols, Tangents);
 			}
-			//update procedurally generated ocean mesh
-			OceanMesh->UpdateMeshSection(0, Verts, Normals, UV0, VertCols, Tangents);
 		}
 	}
 }
 
+// Move and rotate the ocean to follow the player's view, snapping to the world aligned lattice if enabled
+void AOcean::FollowView(FVector Location, float Yaw)
+{
+	if (bSnapToLattice)
+	{
+		//snap to lattice so the ocean verts sit on the same world positions between snaps
+		if (LatticeSnapSize > 0.f)
+		{
+			Location.X = FMath::GridSnap(Location.X, LatticeSnapSize);
+			Location.Y = FMath::GridSnap(Location.Y, LatticeSnapSize);
+		}
+		if (LatticeSnapYaw > 0.f)
+		{
+			Yaw = FMath::GridSnap(Yaw, LatticeSnapYaw);
+		}
+	}
+
+	//only move when needed, so a snapped ocean is left alone between snaps
+	if (!Location.Equals(GetActorLocation()))
+	{
+		SetActorLocation(Location);
+	}
+	if (!FMath::IsNearlyEqual(FRotator::NormalizeAxis(Yaw - GetActorRotation().Yaw), 0.f))
+	{
+		SetActorRotation(FRotator(0.f, Yaw, 0.f));
+	}
+}
+
+// Refit and rebuild the grid if the viewport size or field of view has changed since the last fit
+void AOcean::UpdateGridFit()
+{
+	UGameViewportClient* GameViewport = GetWorld()->GetGameViewport();
+	APlayerCameraManager* CameraManager = UGameplayStatics::GetPlayerCameraManager(this, 0);
+	if (!GameViewport || !GameViewport->Viewport || !CameraManager) return;
+
+	FIntPoint ViewportSize = GameViewport->Viewport->GetSizeXY();
+	float FOV = CameraManager->GetFOVAngle();
+
+	//viewport not ready yet
+	if (ViewportSize.X <= 0 || ViewportSize.Y <= 0) return;
+
+	if (ViewportSize == FittedViewportSize && FMath::IsNearlyEqual(FOV, FittedFOV)) return;
+
+	FittedViewportSize = ViewportSize;
+	FittedFOV = FOV;
+
+	FitGridToView(ViewportSize, FOV);
+	CreateGridVerts();
+}
+
+// Generate grid stage count, Y scale and expansion curve that meet the pixels per triangle target with the fewest verts
+void AOcean::FitGridToView(FIntPoint ViewportSize, float FOV)
+{
+	//horizontal fov is the FOV angle, vertical follows from the aspect ratio - grid must cover the wider of the two when rotated
+	float TanHalfFOV = FMath::Tan(FMath::DegreesToRadians(FMath::Clamp(FOV, 1.f, 170.f)) / 2.f);
+
+	//grid fan half angle has tan = GridYScale / sqrt(3), so scale it to cover the horizontal fov
+	GridYScale = FMath::Sqrt(3.f) * TanHalfFOV * FitFOVMargin;
+
+	//target triangle edge as a fraction of distance - edge in pixels times the size of a pixel at distance 1
+	float EdgePixels = FMath::Sqrt(4.f * FMath::Max(TargetPixelsPerTriangle, 1.f) / FMath::Sqrt(3.f));
+	float EdgePerDistance = EdgePixels * (2.f * TanHalfFOV / ViewportSize.X);
+
+	//stage row height before expansion
+	float StageHeight = (FMath::Sqrt(3.f) * GridCellSize) / 2.f;
+
+	//the grid is a fan, so the spacing along a stage is (stage distance * fan width) / stage number - stages below this
+	//number would be too coarse across the view if expanded, so they are kept at the unexpanded cell size
+	float FanWidth = 2.f * GridYScale / FMath::Sqrt(3.f);
+	int32 UniformStages = FMath::Max(FMath::CeilToInt(FanWidth / EdgePerDistance), 2);
+
+	//build expansion curve - factor that takes each stage's unexpanded distance to its expanded distance
+	UCurveFloat* FittedCurve = NewObject<UCurveFloat>(this);
+	FittedCurve->FloatCurve.AddKey(0.f, 1.f);
+	FittedCurve->FloatCurve.AddKey(UniformStages * StageHeight, 1.f);
+
+	//beyond the uniform stages each stage's row height grows with distance, so distance grows geometrically per stage
+	int32 Stages = UniformStages;
+	float StageDistance = UniformStages * StageHeight;
+	float StageGrowth = 1.f + EdgePerDistance * FMath::Sqrt(3.f) / 2.f;
+	while (StageDistance < FitMaxDistance && Stages < 1000)
+	{
+		StageDistance = FMath::Max(StageDistance * StageGrowth, StageDistance + StageHeight);
+		Stages++;
+		FittedCurve->FloatCurve.AddKey(Stages * StageHeight, StageDistance / (Stages * StageHeight));
+	}
+
+	GridStage = Stages + 1;
+	GridExpansionCurve = FittedCurve;
+
+	int32 NumVerts = (GridStage * (GridStage + 1)) / 2;
+	int32 NumWaves = WaveManager ? WaveManager->GetNumWaveForms() : 0;
+	UE_LOG(LogTemp, Log, TEXT("Ocean grid fitted to %dx%d at %.1f fov: %d stages (%d uniform), %d verts, %d tris, predicted %d wave evaluations per frame."), ViewportSize.X, ViewportSize.Y, FOV, GridStage, UniformStages, NumVerts, (GridStage - 1) * (GridStage - 1), NumVerts * NumWaves);
+}
+
+// Rebuild the spatial phase cache if the ocean has snapped since it was built, returns whether the cache can be used
+bool AOcean::UpdatePhaseCache()
+{
+	//cached phase is only constant while the verts stay on the same world positions
+	if (!bCachePhase || !bSnapToLattice || !WaveManager || WaveManager->GetNumWaveForms() == 0)
+	{
+		PhaseCacheValid = false;
+		PhaseCache.Empty();
+		return false;
+	}
+
+	if (PhaseCacheValid && PhaseCacheWaveVersion == WaveManager->GetWaveVersion() && PhaseCacheLocation.Equals(GetActorLocation()) && PhaseCacheRotation.Equals(GetActorRotation()))
+	{
+		return true;
+	}
+
+	PhaseCacheValid = false;
+	PhaseCacheWaveVersion = WaveManager->GetWaveVersion();
+	PhaseCacheLocation = GetActorLocation();
+	PhaseCacheRotation = GetActorRotation();
+
+	//check the cache fits in the memory budget - fall back to full evaluation if not
+	float CacheMegabytes = (float)GridVerts.Num() * WaveManager->GetNumWaveForms() * sizeof(FVector2D) / (1024.f * 1024.f);
+	if (CacheMegabytes > PhaseCacheMaxMegabytes)
+	{
+		if (!PhaseCacheOverBudget)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Ocean phase cache needs %.2f MB (%d verts x %d waves), over %.2f MB cap - falling back to full wave evaluation."), CacheMegabytes, GridVerts.Num(), WaveManager->GetNumWaveForms(), PhaseCacheMaxMegabytes);
+			PhaseCacheOverBudget = true;
+		}
+		PhaseCache.Empty();
+		return false;
+	}
+	if (PhaseCacheOverBudget || PhaseCache.Num() == 0)
+	{
+		UE_LOG(LogTemp, Log, TEXT("Ocean phase cache using %.2f MB (%d verts x %d waves)."), CacheMegabytes, GridVerts.Num(), WaveManager->GetNumWaveForms());
+	}
+	PhaseCacheOverBudget = false;
+
+	//find world positions of all grid verts
+	TArray<FVector2D> Positions;
+	Positions.SetNumUninitialized(GridVerts.Num());
+	for (int32 i = 0; i < GridVerts.Num(); i++)
+	{
+		FVector VertAbsolute = PhaseCacheLocation + PhaseCacheRotation.RotateVector(GridVerts[i]);
+		Positions[i] = FVector2D(VertAbsolute.X, VertAbsolute.Y);
+	}
+
+	PhaseCacheValid = WaveManager->CacheSpatialPhase(Positions, PhaseCache);
+	return PhaseCacheValid;
+}
+
 // Create a triangular grid of vertices that will form the ocean
 void AOcean::CreateGridVerts()
 {
@@ -149,6 +378,11 @@ void AOcean::CreateGridVerts()
 		}
 	}
 
+	//reorder tris and verts for vertex cache reuse - grid is built stage by stage, which reuses the cache poorly
+	TArray<int32> OldToNew;
+	FMeshGridOptimizer::Optimize(Tris, Verts.Num(), OldToNew, TEXT("Ocean"));
+	FMeshGridOptimizer::RemapVerts(Verts, OldToNew);
+
 	//declare other mesh arrays
 	TArray<FVector> Normals;
 	TArray<FVector2D> UV0;
@@ -158,6 +392,7 @@ void AOcean::CreateGridVerts()
 	//scale/offset the verts and add them to the final mesh grid
 
 	GridVerts.Empty();
+	PhaseCacheValid = false;
 	for (int32 i = 0; i < Verts.Num(); i++)
 	{
 		FVector ExpandedVert = Verts[i];
@@ -175,15 +410,47 @@ void AOcean::CreateGridVerts()
 		UV0.Add(FVector2D(ExpandedVert.X, ExpandedVert.Y) / GridUVSize);
 	}	
 
-	if (OceanMesh)
+	if (bCompactVertexStream && CompactOceanMesh)
+	{
+		//quantization extent must reach the furthest grid vert after wave displacement
+		float QuantizationExtent = 0.f;
+		for (int32 i = 0; i < GridVerts.Num(); i++)
+		{
+			QuantizationExtent = FMath::Max(QuantizationExtent, GridVerts[i].GetAbsMax());
+		}
+		QuantizationExtent += CompactVertexMargin;
+
+		//create compact mesh from the grid
+		CompactOceanMesh->CreateMesh(Tris, UV0, QuantizationExtent);
+		if (WaveMaterial)
+		{
+			CompactOceanMesh->SetMaterial(0, GetOceanMaterial());
+		}
+		CompactStreamBuilt = true;
+		GridBuilt = true;
+		UE_LOG(LogTemp, Log, TEXT("Grid Complete, %d tris, compact vertex stream %d bytes per frame (%.2f cm precision)."), Tris.Num(), GridVerts.Num() * (int32)sizeof(FOceanCompactVertex), QuantizationExtent / 32767.f);
+	}
+	else if (OceanMesh)
 	{
 		//create procedural mesh from the grid
 		OceanMesh->CreateMeshSection(0, GridVerts, Tris, Normals, UV0, VertCols, Tangents, false);
 		if (WaveMaterial)
 		{
-			OceanMesh->SetMaterial(0, WaveMaterial);
+			OceanMesh->SetMaterial(0, GetOceanMaterial());
 		}
 		GridBuilt = true;
 		UE_LOG(LogTemp, Log, TEXT("Grid Complete, %d tris."), Tris.Num());
 	}
-}
\ No newline at end of file
+}
+
+// Material for the ocean mesh, a dynamic instance of the wave material when it samples the foam map
+UMaterialInterface* AOcean::GetOceanMaterial()
+{
+	if (!bUseFoamMap) return WaveMaterial;
+
+	if (!DynamicWaveMat)
+	{
+		DynamicWaveMat = UMaterialInstanceDynamic::Create(WaveMaterial, this);
+	}
+	return DynamicWaveMat;
+}
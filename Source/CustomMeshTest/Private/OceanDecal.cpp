@@ -4,6 +4,7 @@
 #include "ProceduralMeshComponent.h"
 #include "WaveManager.h"
 #include "CustomMeshTestGameMode.h"
+#include "MeshGridOptimizer.h"
 #include "OceanDecal.h"
 
 
@@ -51,21 +52,18 @@ void AOceanDecal::BeginPlay()
 void AOceanDecal::Tick( float DeltaTime )
 {
 	Super::Tick( DeltaTime );
+
+	UpdateWaveMesh();
+}
+
+// Move the decal mesh's verts onto the waves for this frame
+void AOceanDecal::UpdateWaveMesh()
+{
 	if (GridBuilt && OceanMesh)
 	{
-		//get game wave manager
-		if (!WaveManager)
-		{
-			AGameMode* GameMode = UGameplayStatics::GetGameMode(this);
-			if (GameMode)
-			{
-				ACustomMeshTestGameMode* CustomGameMode = Cast<ACustomMeshTestGameMode>(GameMode);
-				if (CustomGameMode)
-				{
-					WaveManager = CustomGameMode->GetWaveManager();
-				}
-			}
-		}
+		//waves and time for this frame
+		const FOceanContext* Ocean = ACustomMeshTestGameMode::FindOceanContext(this);
+		WaveManager = Ocean ? Ocean->WaveManager : nullptr;
 		if (WaveManager)
 		{
 			//declare mesh arrays
@@ -76,15 +74,16 @@ void AOceanDecal::Tick( float DeltaTime )
 			TArray<FColor> VertCols;
 
 			//for every vert
+			const TArray<FVector> &GridVerts = GridTopology->Verts;
 			for (int32 i = 0; i < GridVerts.Num(); i++)
 			{
 				//calculate absolute world location of the vert based on grid
 				FVector VertAbsolute = GetActorLocation() + GetActorRotation().RotateVector(GridVerts[i]);
 
-				//find the displacement and normal of the wave at this location at the current game time
+				//find the displacement and normal of the wave at this location at this frame's ocean time
 				FVector WaveDisplacement;
 				FVector WaveNormal;
-				WaveManager->GetWaveDisplacementNormal(FVector2D(VertAbsolute.X, VertAbsolute.Y), GetWorld()->GetTimeSeconds(), WaveDisplacement, WaveNormal);
+				WaveManager->GetWaveDisplacementNormal(FVector2D(VertAbsolute.X, VertAbsolute.Y), Ocean->Time, WaveDisplacement, WaveNormal);
 
 				//calculate the relative location and normal of the vert to the decal actor
 				FVector VertAbsoluteDisplacement = VertAbsolute + WaveDisplacement;
@@ -103,8 +102,62 @@ void AOceanDecal::Tick( float DeltaTime )
 
 }
 
-// Create a hexagonal grid of vertices that will form the ocean decal
+// Create the ocean decal mesh from the shared hexagonal grid for this decal's grid parameters
 void AOceanDecal::CreateGridVerts()
+{
+	GridTopology = GetGridTopology(GridStage, GridCellSize);
+
+	if (OceanMesh && GridTopology.IsValid())
+	{
+		//declare other mesh arrays
+		TArray<FVector> Normals;
+		TArray<FColor> VertCols;
+		TArray<FProcMeshTangent> Tangents;
+
+		//create procedural mesh from the grid
+		OceanMesh->CreateMeshSection(0, GridTopology->Verts, GridTopology->Tris, Normals, GridTopology->UVs, VertCols, Tangents, false);
+		if (WaveMaterial)
+		{
+			OceanMesh->SetMaterial(0, WaveMaterial);
+		}
+		GridBuilt = true;
+	}
+}
+
+// Switch the decal mesh to another shared grid, e.g. a coarser one when the decal is far away - keeps the decal's materials
+void AOceanDecal::SetGridTopology(TSharedPtr<const FOceanDecalGridTopology> NewGridTopology)
+{
+	if (!OceanMesh || !NewGridTopology.IsValid() || NewGridTopology == GridTopology) return;
+
+	GridTopology = NewGridTopology;
+
+	TArray<FVector> Normals;
+	TArray<FColor> VertCols;
+	TArray<FProcMeshTangent> Tangents;
+	OceanMesh->CreateMeshSection(0, GridTopology->Verts, GridTopology->Tris, Normals, GridTopology->UVs, VertCols, Tangents, false);
+	GridBuilt = true;
+}
+
+// Find the shared grid for the given grid parameters, building it the first time they are used
+TSharedPtr<const FOceanDecalGridTopology> AOceanDecal::GetGridTopology(int32 Stage, float CellSize)
+{
+	//grids shared by every decal in the process
+	static TMap<FOceanDecalGridKey, TSharedPtr<const FOceanDecalGridTopology>> GridCache;
+
+	FOceanDecalGridKey Key(Stage, CellSize);
+	TSharedPtr<const FOceanDecalGridTopology>* CachedTopology = GridCache.Find(Key);
+	if (CachedTopology)
+	{
+		return *CachedTopology;
+	}
+
+	TSharedPtr<const FOceanDecalGridTopology> NewTopology = BuildGridTopology(Stage, CellSize);
+	GridCache.Add(Key, NewTopology);
+	return NewTopology;
+}
+
+// Create a hexagonal grid of vertices that will form the ocean decal
+TSharedPtr<const FOceanDecalGridTopology> AOceanDecal::BuildGridTopology(int32 Stage, float CellSize)
 {
 	//declare grid mesh arrays
 	TArray<FGridVert> Verts;
@@ -112,9 +165,9 @@ void AOceanDecal::CreateGridVerts()
 	TArray<FGridEdge> Edges;
 
 	//initial triangle
-	Verts.Add(FGridVert(FVector(0, -FMath::Sqrt(0.75)*GridCellSize / 2.f, 0), 0, true));
-	Verts.Add(FGridVert(FVector(-0.5*GridCellSize, FMath::Sqrt(0.75)*GridCellSize / 2.f, 0), 0, true));
-	Verts.Add(FGridVert(FVector(0.5*GridCellSize, FMath::Sqrt(0.75)*GridCellSize / 2.f, 0), 0, true));
+	Verts.Add(FGridVert(FVector(0, -FMath::Sqrt(0.75)*CellSize / 2.f, 0), 0, true));
+	Verts.Add(FGridVert(FVector(-0.5*CellSize, FMath::Sqrt(0.75)*CellSize / 2.f, 0), 0, true));
+	Verts.Add(FGridVert(FVector(0.5*CellSize, FMath::Sqrt(0.75)*CellSize / 2.f, 0), 0, true));
 
 	Edges.Add(FGridEdge(0, 1));
 	Edges.Add(FGridEdge(1, 2));
@@ -125,7 +178,7 @@ void AOceanDecal::CreateGridVerts()
 	Tris.Add(2);
 
 	//grid is created in stages - each stage covers the outside edge of the grid in a new layer of tris
-	for (int32 i = 0; i < GridStage; i++)
+	for (int32 i = 0; i < Stage; i++)
 	{
 		//keep track of the edges created in this stage - outside edges will become the base to build off next stage
 		TArray<FGridEdge> NewEdges;
@@ -137,7 +190,7 @@ void AOceanDecal::CreateGridVerts()
 			if (Verts[Edges[j].V1].Stage == Verts[Edges[j].V2].Stage)
 			{
 				//create OnPoint vert - creating a triangle pointing away from the edge (located on flat hexagon corners)
-				FVector2D NewVertPos = TriangulateEdge(Verts[Edges[j].V1].Vert, Verts[Edges[j].V2].Vert);
+				FVector2D NewVertPos = TriangulateEdge(Verts[Edges[j].V1].Vert, Verts[Edges[j].V2].Vert, CellSize);
 
 				int32 NewVertIndex = Verts.Num();
 				Verts.Add(FGridVert(FVector(NewVertPos.X, NewVertPos.Y, 0), i + 1, true));
@@ -158,7 +211,7 @@ void AOceanDecal::CreateGridVerts()
 				if (Verts[Edges[j].V2].OnPoint)
 				{
 					//start the true cluster (group of 3 triangles, with 2 new verts - located on top of a OnPoint tri, so also at hexagon corners)
-					FVector2D NewVertPos = TriangulateEdge(Verts[Edges[j].V1].Vert, Verts[Edges[j].V2].Vert);
+					FVector2D NewVertPos = TriangulateEdge(Verts[Edges[j].V1].Vert, Verts[Edges[j].V2].Vert, CellSize);
 
 					int32 NewVertIndex = Verts.Num();
 					Verts.Add(FGridVert(FVector(NewVertPos.X, NewVertPos.Y, 0), i + 1, false));
@@ -204,7 +257,7 @@ void AOceanDecal::CreateGridVerts()
 			else
 			{
 				//ClusterEnd - this completes the partially formed true or false cluster
-				FVector2D NewVertPos = TriangulateEdge(Verts[Edges[j].V1].Vert, Verts[Edges[j].V2].Vert);
+				FVector2D NewVertPos = TriangulateEdge(Verts[Edges[j].V1].Vert, Verts[Edges[j].V2].Vert, CellSize);
 
 				int32 NewVertIndex = Verts.Num();
 				Verts.Add(FGridVert(FVector(NewVertPos.X, NewVertPos.Y, 0), i + 1, false));
@@ -222,46 +275,36 @@ void AOceanDecal::CreateGridVerts()
 
 	}
 
+	//reorder tris and verts for vertex cache reuse - grid is built edge by edge, which reuses the cache poorly
+	TArray<int32> OldToNew;
+	FMeshGridOptimizer::Optimize(Tris, Verts.Num(), OldToNew, TEXT("Ocean decal"));
+	FMeshGridOptimizer::RemapVerts(Verts, OldToNew);
 
-	//declare other mesh arrays
-	TArray<FVector> Normals;
-	TArray<FVector2D> UV0;
-	TArray<FColor> VertCols;
-	TArray<FProcMeshTangent> Tangents;
+	//add the verts to the final mesh grid
 
-	//scale/offset the verts and add them to the final mesh grid
-
-	GridVerts.Empty();
+	TSharedPtr<FOceanDecalGridTopology> Topology = MakeShareable(new FOceanDecalGridTopology());
+	Topology->Tris = Tris;
 	for (int32 i = 0; i < Verts.Num(); i++)
 	{
 		FVector ExpandedVert = Verts[i].Vert;
-		GridVerts.Add(ExpandedVert);
+		Topology->Verts.Add(ExpandedVert);
 
 		//calculate UV coordinates
-		UV0.Add(FVector2D(ExpandedVert.X, ExpandedVert.Y) / (GridCellSize*GridStage) + FVector2D(0.5f, 0.5f));
+		Topology->UVs.Add(FVector2D(ExpandedVert.X, ExpandedVert.Y) / (CellSize*Stage) + FVector2D(0.5f, 0.5f));
 	}
 
+	UE_LOG(LogTemp, Log, TEXT("Decal Grid Complete, %d tris, shared by all decals with stage %d cell size %.1f."), Tris.Num(), Stage, CellSize);
 
-	if (OceanMesh)
-	{
-		//create procedural mesh from the grid
-		OceanMesh->CreateMeshSection(0, GridVerts, Tris, Normals, UV0, VertCols, Tangents, false);
-		if (WaveMaterial)
-		{
-			OceanMesh->SetMaterial(0, WaveMaterial);
-		}
-		GridBuilt = true;
-		UE_LOG(LogTemp, Log, TEXT("Grid Complete, %d tris."), Tris.Num());
-	}
+	return Topology;
 }
 
 // Find the point that will form an equilatiral triangle with 2 given points
-FVector2D AOceanDecal::TriangulateEdge(FVector V1, FVector V2)
+FVector2D AOceanDecal::TriangulateEdge(FVector V1, FVector V2, float CellSize)
 {
 	//calculate vector between 2 given points
 	FVector2D EdgeVector = FVector2D(V2.X - V1.X, V2.Y - V1.Y);
 	EdgeVector.Normalize();
-	EdgeVector *= GridCellSize;
+	EdgeVector *= CellSize;
 
 	//calculate dividing normal of the equilatiral triangle
 	FVector2D EdgeNormal = FVector2D(-EdgeVector.Y, EdgeVector.X);
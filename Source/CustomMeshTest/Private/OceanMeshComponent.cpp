@@ -0,0 +1,331 @@
+// Visual only - mesh component for the ocean grid with a compact vertex stream: quantized positions and packed normals are the only data sent every frame
+
+#include "CustomMeshTest.h"
+#include "LocalVertexFactory.h"
+#include "OceanMeshComponent.h"
+
+
+//vertex in the static stream of the ocean mesh, uploaded once
+struct FOceanStaticVertex
+{
+	FVector2DHalf UV;
+};
+
+//per frame vertex stream - quantized positions and packed normals
+class FOceanDynamicVertexBuffer : public FVertexBuffer
+{
+public:
+
+	TArray<FOceanCompactVertex> Verts;
+
+	virtual void InitRHI() override
+	{
+		FRHIResourceCreateInfo CreateInfo;
+		void* Buffer = nullptr;
+		VertexBufferRHI = RHICreateAndLockVertexBuffer(FMath::Max(Verts.Num(), 1) * sizeof(FOceanCompactVertex), BUF_Dynamic, CreateInfo, Buffer);
+		FMemory::Memcpy(Buffer, Verts.GetData(), Verts.Num() * sizeof(FOceanCompactVertex));
+		RHIUnlockVertexBuffer(VertexBufferRHI);
+	}
+};
+
+//static vertex stream - UVs never change, so are kept out of the per frame stream
+class FOceanStaticVertexBuffer : public FVertexBuffer
+{
+public:
+
+	TArray<FOceanStaticVertex> Verts;
+
+	virtual void InitRHI() override
+	{
+		FRHIResourceCreateInfo CreateInfo;
+		void* Buffer = nullptr;
+		VertexBufferRHI = RHICreateAndLockVertexBuffer(FMath::Max(Verts.Num(), 1) * sizeof(FOceanStaticVertex), BUF_Static, CreateInfo, Buffer);
+		FMemory::Memcpy(Buffer, Verts.GetData(), Verts.Num() * sizeof(FOceanStaticVertex));
+		RHIUnlockVertexBuffer(VertexBufferRHI);
+	}
+};
+
+//single tangent shared by every vert (zero stride) - tangents are derived in the material, so none are sent per vert
+class FOceanConstantTangentBuffer : public FVertexBuffer
+{
+public:
+
+	virtual void InitRHI() override
+	{
+		FRHIResourceCreateInfo CreateInfo;
+		void* Buffer = nullptr;
+		VertexBufferRHI = RHICreateAndLockVertexBuffer(sizeof(FPackedNormal), BUF_Static, CreateInfo, Buffer);
+		*(FPackedNormal*)Buffer = FPackedNormal(FVector(1.f, 0.f, 0.f));
+		RHIUnlockVertexBuffer(VertexBufferRHI);
+	}
+};
+
+TGlobalResource<FOceanConstantTangentBuffer> GOceanConstantTangentBuffer;
+
+class FOceanIndexBuffer : public FIndexBuffer
+{
+public:
+
+	TArray<int32> Tris;
+
+	virtual void InitRHI() override
+	{
+		FRHIResourceCreateInfo CreateInfo;
+		void* Buffer = nullptr;
+		IndexBufferRHI = RHICreateAndLockIndexBuffer(sizeof(int32), FMath::Max(Tris.Num(), 1) * sizeof(int32), BUF_Static, CreateInfo, Buffer);
+		FMemory::Memcpy(Buffer, Tris.GetData(), Tris.Num() * sizeof(int32));
+		RHIUnlockIndexBuffer(IndexBufferRHI);
+	}
+};
+
+class FOceanVertexFactory : public FLocalVertexFactory
+{
+public:
+
+	// Bind the compact streams - must be called on the render thread
+	void Init_RenderThread(const FOceanDynamicVertexBuffer* DynamicBuffer, const FOceanStaticVertexBuffer* StaticBuffer)
+	{
+		check(IsInRenderingThread());
+
+		DataType NewData;
+		NewData.PositionComponent = FVertexStreamComponent(DynamicBuffer, STRUCT_OFFSET(FOceanCompactVertex, Position), sizeof(FOceanCompactVertex), VET_Short4N);
+		NewData.TangentBasisComponents[0] = FVertexStreamComponent(&GOceanConstantTangentBuffer, 0, 0, VET_PackedNormal);
+		NewData.TangentBasisComponents[1] = FVertexStreamComponent(DynamicBuffer, STRUCT_OFFSET(FOceanCompactVertex, Normal), sizeof(FOceanCompactVertex), VET_PackedNormal);
+		NewData.TextureCoordinates.Add(FVertexStreamComponent(StaticBuffer, STRUCT_OFFSET(FOceanStaticVertex, UV), sizeof(FOceanStaticVertex), VET_Half2));
+		SetData(NewData);
+	}
+
+	// Bind the compact streams from any thread
+	void Init(const FOceanDynamicVertexBuffer* DynamicBuffer, const FOceanStaticVertexBuffer* StaticBuffer)
+	{
+		if (IsInRenderingThread())
+		{
+			Init_RenderThread(DynamicBuffer, StaticBuffer);
+		}
+		else
+		{
+			ENQUEUE_UNIQUE_RENDER_COMMAND_THREEPARAMETER(
+				InitOceanVertexFactory,
+				FOceanVertexFactory*, VertexFactory, this,
+				const FOceanDynamicVertexBuffer*, DynamicBuffer, DynamicBuffer,
+				const FOceanStaticVertexBuffer*, StaticBuffer, StaticBuffer,
+				{
+					VertexFactory->Init_RenderThread(DynamicBuffer, StaticBuffer);
+				});
+		}
+	}
+};
+
+class FOceanMeshSceneProxy : public FPrimitiveSceneProxy
+{
+private:
+
+	UMaterialInterface* Material;
+
+	FOceanDynamicVertexBuffer DynamicBuffer;
+
+	FOceanStaticVertexBuffer StaticBuffer;
+
+	FOceanIndexBuffer IndexBuffer;
+
+	FOceanVertexFactory VertexFactory;
+
+	FMaterialRelevance MaterialRelevance;
+
+public:
+
+	FOceanMeshSceneProxy(UOceanMeshComponent* Component)
+		: FPrimitiveSceneProxy(Component)
+		, MaterialRelevance(Component->GetMaterialRelevance(GetScene().GetFeatureLevel()))
+	{
+		//copy grid data for the render thread
+		DynamicBuffer.Verts = Component->GetVerts();
+		IndexBuffer.Tris = Component->GetTris();
+
+		const TArray<FVector2D> &UVs = Component->GetUVs();
+		StaticBuffer.Verts.SetNumUninitialized(UVs.Num());
+		for (int32 i = 0; i < UVs.Num(); i++)
+		{
+			StaticBuffer.Verts[i].UV = FVector2DHalf(UVs[i]);
+		}
+
+		VertexFactory.Init(&DynamicBuffer, &StaticBuffer);
+
+		BeginInitResource(&DynamicBuffer);
+		BeginInitResource(&StaticBuffer);
+		BeginInitResource(&IndexBuffer);
+		BeginInitResource(&VertexFactory);
+
+		Material = Component->GetMaterial(0);
+		if (!Material)
+		{
+			Material = UMaterial::GetDefaultMaterial(MD_Surface);
+		}
+	}
+
+	virtual ~FOceanMeshSceneProxy()
+	{
+		DynamicBuffer.ReleaseResource();
+		StaticBuffer.ReleaseResource();
+		IndexBuffer.ReleaseResource();
+		VertexFactory.ReleaseResource();
+	}
+
+	// Copy this frame's verts into the dynamic vertex buffer - called on the render thread
+	void UpdateVerts_RenderThread(TArray<FOceanCompactVertex>* NewVerts)
+	{
+		check(IsInRenderingThread());
+
+		if (NewVerts->Num() == DynamicBuffer.Verts.Num() && NewVerts->Num() > 0)
+		{
+			void* Buffer = RHILockVertexBuffer(DynamicBuffer.VertexBufferRHI, 0, NewVerts->Num() * sizeof(FOceanCompactVertex), RLM_WriteOnly);
+			FMemory::Memcpy(Buffer, NewVerts->GetData(), NewVerts->Num() * sizeof(FOceanCompactVertex));
+			RHIUnlockVertexBuffer(DynamicBuffer.VertexBufferRHI);
+		}
+
+		delete NewVerts;
+	}
+
+	virtual void GetDynamicMeshElements(const TArray<const FSceneView*> &Views, const FSceneViewFamily &ViewFamily, uint32 VisibilityMap, FMeshElementCollector &Collector) const override
+	{
+		if (IndexBuffer.Tris.Num() == 0) return;
+
+		FMaterialRenderProxy* MaterialProxy = Material->GetRenderProxy(IsSelected());
+
+		for (int32 ViewIndex = 0; ViewIndex < Views.Num(); ViewIndex++)
+		{
+			if (VisibilityMap & (1 << ViewIndex))
+			{
+				FMeshBatch &Mesh = Collector.AllocateMesh();
+				FMeshBatchElement &BatchElement = Mesh.Elements[0];
+				BatchElement.IndexBuffer = &IndexBuffer;
+				BatchElement.PrimitiveUniformBufferResource = &GetUniformBuffer();
+				BatchElement.FirstIndex = 0;
+				BatchElement.NumPrimitives = IndexBuffer.Tris.Num() / 3;
+				BatchElement.MinVertexIndex = 0;
+				BatchElement.MaxVertexIndex = DynamicBuffer.Verts.Num() - 1;
+				Mesh.VertexFactory = &VertexFactory;
+				Mesh.MaterialRenderProxy = MaterialProxy;
+				Mesh.ReverseCulling = IsLocalToWorldDeterminantNegative();
+				Mesh.Type = PT_TriangleList;
+				Mesh.DepthPriorityGroup = SDPG_World;
+				Mesh.bCanApplyViewModeOverrides = false;
+				Collector.AddMesh(ViewIndex, Mesh);
+			}
+		}
+	}
+
+	virtual FPrimitiveViewRelevance GetViewRelevance(const FSceneView* View) const override
+	{
+		FPrimitiveViewRelevance Result;
+		Result.bDrawRelevance = IsShown(View);
+		Result.bShadowRelevance = IsShadowCast(View);
+		Result.bDynamicRelevance = true;
+		Result.bRenderInMainPass = ShouldRenderInMainPass();
+		Result.bRenderCustomDepth = ShouldRenderCustomDepth();
+		MaterialRelevance.SetPrimitiveViewRelevance(Result);
+		return Result;
+	}
+
+	virtual bool CanBeOccluded() const override
+	{
+		return !MaterialRelevance.bDisableDepthTest;
+	}
+
+	virtual uint32 GetMemoryFootprint() const override
+	{
+		return sizeof(*this) + GetAllocatedSize();
+	}
+};
+
+
+// Sets default values for this component's properties
+UOceanMeshComponent::UOceanMeshComponent()
+{
+	QuantizationExtent = 1.f;
+
+	//visual only
+	SetCollisionEnabled(ECollisionEnabled::NoCollision);
+}
+
+// Create the mesh from static grid data - QuantizationExtent is the largest distance from the component any vert can reach
+void UOceanMeshComponent::CreateMesh(const TArray<int32> &GridTris, const TArray<FVector2D> &GridUVs, float Extent)
+{
+	Tris = GridTris;
+	UVs = GridUVs;
+	QuantizationExtent = FMath::Max(Extent, 1.f);
+
+	//start flat until the first verts are written
+	Verts.SetNumUninitialized(UVs.Num());
+	for (int32 i = 0; i < Verts.Num(); i++)
+	{
+		Verts[i].Set(FVector::ZeroVector, FVector::UpVector, 1.f / QuantizationExtent);
+	}
+
+	//quantized positions are -1 to 1, so scale the component up to the quantization extent
+	SetRelativeScale3D(FVector(QuantizationExtent));
+
+	//recreate scene proxy with the new grid
+	MarkRenderStateDirty();
+}
+
+// Per frame vertex stream to write this frame's verts into, then send with UpdateMesh
+TArray<FOceanCompactVertex>& UOceanMeshComponent::GetVertsForWrite()
+{
+	return Verts;
+}
+
+// 1 / quantization extent, for FOceanCompactVertex::Set
+float UOceanMeshComponent::GetInvQuantizationExtent()
+{
+	return 1.f / QuantizationExtent;
+}
+
+// Send the per frame vertex stream to the render thread
+void UOceanMeshComponent::UpdateMesh()
+{
+	if (!SceneProxy) return;
+
+	//verts are already in their final compact form, so this is a straight copy for the render thread
+	TArray<FOceanCompactVertex>* NewVerts = new TArray<FOceanCompactVertex>(Verts);
+
+	ENQUEUE_UNIQUE_RENDER_COMMAND_TWOPARAMETER(
+		FOceanMeshUpdate,
+		FOceanMeshSceneProxy*, OceanSceneProxy, (FOceanMeshSceneProxy*)SceneProxy,
+		TArray<FOceanCompactVertex>*, NewVerts, NewVerts,
+		{
+			OceanSceneProxy->UpdateVerts_RenderThread(NewVerts);
+		});
+}
+
+const TArray<int32>& UOceanMeshComponent::GetTris() const
+{
+	return Tris;
+}
+
+const TArray<FVector2D>& UOceanMeshComponent::GetUVs() const
+{
+	return UVs;
+}
+
+const TArray<FOceanCompactVertex>& UOceanMeshComponent::GetVerts() const
+{
+	return Verts;
+}
+
+FPrimitiveSceneProxy* UOceanMeshComponent::CreateSceneProxy()
+{
+	if (Tris.Num() == 0) return nullptr;
+	return new FOceanMeshSceneProxy(this);
+}
+
+int32 UOceanMeshComponent::GetNumMaterials() const
+{
+	return 1;
+}
+
+FBoxSphereBounds UOceanMeshComponent::CalcBounds(const FTransform &LocalToWorld) const
+{
+	//verts are quantized into -1 to 1, so that box always contains them
+	return FBoxSphereBounds(FBox(FVector(-1.f), FVector(1.f))).TransformBy(LocalToWorld);
+}
@@ -0,0 +1,253 @@
+// Scores every ocean actor by how much it matters to the view and sets how often it ticks and animates, whether it spawns foam and how its float is simulated by tier
+
+#include "CustomMeshTest.h"
+#include "CustomMeshTestGameMode.h"
+#include "FloatComponent.h"
+#include "OceanSignificanceManager.h"
+
+
+// Sets default values
+AOceanSignificanceManager::AOceanSignificanceManager()
+{
+ 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
+	PrimaryActorTick.bCanEverTick = true;
+
+	NextScored = 0;
+	ScoreAccumulator = 0.f;
+	SkippedTicks = 0.f;
+	AverageTickCost = 0.f;
+	ReportTimer = 0.f;
+	SkippedTicksPerSecond = 0.f;
+
+	//default scoring params
+	ScoreInterval = 0.5f;
+	RecentRenderTime = 1.f;
+	HiddenScoreScale = 0.25f;
+
+	//default tier params
+	TierScreenSizes.Add(0.1f);
+	TierScreenSizes.Add(0.02f);
+	TierScreenSizes.Add(0.005f);
+
+	TierTickIntervals.Add(0.f);
+	TierTickIntervals.Add(0.05f);
+	TierTickIntervals.Add(0.2f);
+	TierTickIntervals.Add(1.f);
+
+	TierAnimIntervals.Add(0.f);
+	TierAnimIntervals.Add(0.05f);
+	TierAnimIntervals.Add(0.25f);
+	TierAnimIntervals.Add(1.f);
+
+	FoamMaxTier = 1;
+	RideMinTier = 2;
+
+	//default reporting params
+	ReportInterval = 5.f;
+	bLogReports = false;
+}
+
+// Called when the game starts or when spawned
+void AOceanSignificanceManager::BeginPlay()
+{
+	Super::BeginPlay();
+
+	//tiers are edited after construction, recount any actors registered before play began
+	TierCounts.Reset();
+	TierCounts.SetNumZeroed(FMath::Max(TierTickIntervals.Num(), 1));
+	for (int32 i = 0; i < Actors.Num(); i++)
+	{
+		Tiers[i] = FMath::Min(Tiers[i], TierCounts.Num() - 1);
+		TierCounts[Tiers[i]]++;
+	}
+}
+
+// Called every frame
+void AOceanSignificanceManager::Tick( float DeltaTime )
+{
+	Super::Tick( DeltaTime );
+
+	//actors are scored from the camera
+	FVector ViewLocation = GetActorLocation();
+	APlayerCameraManager* CameraManager = UGameplayStatics::GetPlayerCameraManager(this, 0);
+	if (CameraManager)
+	{
+		ViewLocation = CameraManager->GetCameraLocation();
+	}
+
+	//score a slice of the actors, spread so each is scored once per interval
+	if (Actors.Num() > 0)
+	{
+		const FOceanContext* Ocean = ACustomMeshTestGameMode::FindOceanContext(this);
+		float Time = Ocean ? Ocean->Time : GetWorld()->GetTimeSeconds();
+
+		ScoreAccumulator += Actors.Num() * DeltaTime / FMath::Max(ScoreInterval, KINDA_SMALL_NUMBER);
+		int32 NumToScore = FMath::Min(FMath::FloorToInt(ScoreAccumulator), Actors.Num());
+		ScoreAccumulator -= NumToScore;
+
+		for (int32 i = 0; i < NumToScore; i++)
+		{
+			NextScored = NextScored % Actors.Num();
+			ScoreActor(NextScored++, ViewLocation, Time);
+		}
+	}
+
+	//ticks the lowered tick rates skipped this frame
+	for (int32 Tier = 0; Tier < TierCounts.Num(); Tier++)
+	{
+		float Interval = TierTickIntervals.IsValidIndex(Tier) ? TierTickIntervals[Tier] : 0.f;
+		if (Interval > DeltaTime)
+		{
+			SkippedTicks += TierCounts[Tier] * (1.f - DeltaTime / Interval);
+		}
+	}
+
+	ReportTimer += DeltaTime;
+	if (ReportTimer >= ReportInterval)
+	{
+		SkippedTicksPerSecond = SkippedTicks / ReportTimer;
+		SkippedTicks = 0.f;
+		ReportTimer = 0.f;
+
+		if (bLogReports)
+		{
+			FString TierText;
+			for (int32 Tier = 0; Tier < TierCounts.Num(); Tier++)
+			{
+				TierText += FString::Printf(TEXT("%s%d"), Tier > 0 ? TEXT("/") : TEXT(""), TierCounts[Tier]);
+			}
+			UE_LOG(LogTemp, Log, TEXT("Ocean significance: %d actors in tiers %s, %.0f ticks skipped per second, about %.2f ms saved per second."), Actors.Num(), *TierText, SkippedTicksPerSecond, GetMillisecondsSavedPerSecond());
+		}
+	}
+}
+
+// Score an actor by its size on screen and whether it has been seen lately, and move it to the matching tier
+void AOceanSignificanceManager::ScoreActor(int32 Index, FVector ViewLocation, float Time)
+{
+	AActor* Actor = Actors[Index];
+
+	//size on screen, scaled down for actors that haven't been rendered lately
+	float Distance = FMath::Max(FVector::Dist(Actor->GetActorLocation(), ViewLocation), 1.f);
+	float Score = Radii[Index] / Distance;
+	if (Time - Actor->GetLastRenderTime() > RecentRenderTime)
+	{
+		Score *= HiddenScoreScale;
+	}
+
+	int32 Tier = GetTierForScore(Score);
+	if (Tier == Tiers[Index]) return;
+
+	TierCounts[Tiers[Index]]--;
+	TierCounts[Tier]++;
+	Tiers[Index] = Tier;
+	ApplyTier(Index);
+}
+
+// Set an actor's tick and anim rates and float fidelity for its tier
+void AOceanSignificanceManager::ApplyTier(int32 Index)
+{
+	AActor* Actor = Actors[Index];
+	int32 Tier = Tiers[Index];
+
+	//ticking at an interval still passes on all the time since the last tick, so lifetimes and lerps carry on at the same speed
+	Actor->PrimaryActorTick.TickInterval = TierTickIntervals.IsValidIndex(Tier) ? TierTickIntervals[Tier] : 0.f;
+
+	TInlineComponentArray<USkeletalMeshComponent*> Meshes;
+	Actor->GetComponents(Meshes);
+	for (int32 i = 0; i < Meshes.Num(); i++)
+	{
+		Meshes[i]->PrimaryComponentTick.TickInterval = TierAnimIntervals.IsValidIndex(Tier) ? TierAnimIntervals[Tier] : 0.f;
+	}
+
+	//low tiers ride the waves instead of being simulated
+	UFloatComponent* FloatComp = Actor->FindComponentByClass<UFloatComponent>();
+	if (FloatComp)
+	{
+		FloatComp->SetRideOnly(Tier >= RideMinTier);
+	}
+}
+
+// Tier for a score, highest scores in tier 0
+int32 AOceanSignificanceManager::GetTierForScore(float Score) const
+{
+	int32 LastTier = FMath::Max(TierCounts.Num() - 1, 0);
+	for (int32 Tier = 0; Tier < LastTier && Tier < TierScreenSizes.Num(); Tier++)
+	{
+		if (Score >= TierScreenSizes[Tier]) return Tier;
+	}
+	return LastTier;
+}
+
+// Start managing an actor, in the top tier until it is first scored
+void AOceanSignificanceManager::RegisterActor(AActor* Actor)
+{
+	if (!Actor || ActorIndices.Contains(Actor)) return;
+
+	//size the actor is scored by
+	USceneComponent* Root = Actor->GetRootComponent();
+	float Radius = Root ? Root->Bounds.SphereRadius : 0.f;
+
+	ActorIndices.Add(Actor, Actors.Add(Actor));
+	Tiers.Add(0);
+	Radii.Add(FMath::Max(Radius, 1.f));
+	if (TierCounts.Num() == 0)
+	{
+		TierCounts.SetNumZeroed(1);
+	}
+	TierCounts[0]++;
+
+	//an actor managed before may still have the rates of its old tier
+	ApplyTier(Actors.Num() - 1);
+}
+
+// Stop managing an actor, the last actor takes its index
+void AOceanSignificanceManager::UnregisterActor(AActor* Actor)
+{
+	const int32* FoundIndex = ActorIndices.Find(Actor);
+	if (!FoundIndex) return;
+
+	int32 Index = *FoundIndex;
+	TierCounts[Tiers[Index]]--;
+	ActorIndices.Remove(Actor);
+
+	Actors.RemoveAtSwap(Index);
+	Tiers.RemoveAtSwap(Index);
+	Radii.RemoveAtSwap(Index);
+
+	//the actor that moved is now at this index
+	if (Index < Actors.Num())
+	{
+		ActorIndices.Add(Actors[Index], Index);
+	}
+}
+
+// Tier of a managed actor, 0 if it isn't managed
+int32 AOceanSignificanceManager::GetTier(const AActor* Actor) const
+{
+	const int32* Index = ActorIndices.Find(const_cast<AActor*>(Actor));
+	return Index ? Tiers[*Index] : 0;
+}
+
+// Whether a managed actor's tier lets it spawn foam
+bool AOceanSignificanceManager::IsFoamAllowed(const AActor* Actor) const
+{
+	return GetTier(Actor) <= FoamMaxTier;
+}
+
+// Add the measured length of one managed actor tick to the running average
+void AOceanSignificanceManager::RecordTickCost(float Seconds)
+{
+	AverageTickCost += 0.05f * (Seconds - AverageTickCost);
+}
+
+// Number of managed actors in a tier
+int32 AOceanSignificanceManager::GetTierCount(int32 Tier)
+{
+	return TierCounts.IsValidIndex(Tier) ? TierCounts[Tier] : 0;
+}
+
+// Estimated game thread milliseconds saved per second by lowered tick rates
+float AOceanSignificanceManager::GetMillisecondsSavedPerSecond()
+{
+	return SkippedTicksPerSecond * AverageTickCost * 1000.f;
+}
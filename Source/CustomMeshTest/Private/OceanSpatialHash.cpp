@@ -0,0 +1,328 @@
+// Uniform grid over the ocean plane indexing every float, foam patch and vessel by location, so nearby actors can be found without looking at all of them
+
+#include "CustomMeshTest.h"
+#include "OceanSpatialHash.h"
+
+
+// Sets default values
+AOceanSpatialHash::AOceanSpatialHash()
+{
+	//only changes when indexed actors move, nothing to do per frame
+	PrimaryActorTick.bCanEverTick = false;
+
+	//default grid params
+	CellSize = 2000.f;
+}
+
+// Cell containing a location
+FIntPoint AOceanSpatialHash::GetCell(FVector Location) const
+{
+	return FIntPoint(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize));
+}
+
+// Add an entry to a cell
+void AOceanSpatialHash::AddToCell(FIntPoint Cell, int32 Index)
+{
+	Cells.FindOrAdd(Cell).Add(Index);
+}
+
+// Take an entry out of a cell, removing the cell if it empties
+void AOceanSpatialHash::RemoveFromCell(FIntPoint Cell, int32 Index)
+{
+	TArray<int32>* Entries = Cells.Find(Cell);
+	if (!Entries) return;
+
+	Entries->RemoveSingleSwap(Index);
+	if (Entries->Num() == 0)
+	{
+		Cells.Remove(Cell);
+	}
+}
+
+// Start indexing an actor at its location, or update its kind and location if it is already indexed
+void AOceanSpatialHash::RegisterActor(AActor* Actor, EOceanSpatialKind Kind)
+{
+	if (!Actor) return;
+
+	const int32* FoundIndex = ActorIndices.Find(Actor);
+	if (FoundIndex)
+	{
+		Kinds[*FoundIndex] = Kind;
+		MoveActor(Actor, Actor->GetActorLocation());
+		return;
+	}
+
+	FVector Location = Actor->GetActorLocation();
+	int32 Index = Actors.Add(Actor);
+	Locations.Add(Location);
+	Kinds.Add(Kind);
+	EntryCells.Add(GetCell(Location));
+	ActorIndices.Add(Actor, Index);
+	AddToCell(EntryCells[Index], Index);
+}
+
+// Stop indexing an actor, the last actor takes its index
+void AOceanSpatialHash::UnregisterActor(AActor* Actor)
+{
+	const int32* FoundIndex = ActorIndices.Find(Actor);
+	if (!FoundIndex) return;
+
+	int32 Index = *FoundIndex;
+	int32 LastIndex = Actors.Num() - 1;
+	RemoveFromCell(EntryCells[Index], Index);
+	ActorIndices.Remove(Actor);
+
+	//the actor that moves is now at this index, in its cell too
+	if (Index != LastIndex)
+	{
+		TArray<int32>* Entries = Cells.Find(EntryCells[LastIndex]);
+		int32 Slot = Entries ? Entries->Find(LastIndex) : INDEX_NONE;
+		if (Slot != INDEX_NONE)
+		{
+			(*Entries)[Slot] = Index;
+		}
+		ActorIndices.Add(Actors[LastIndex], Index);
+	}
+
+	Actors.RemoveAtSwap(Index);
+	Locations.RemoveAtSwap(Index);
+	Kinds.RemoveAtSwap(Index);
+	EntryCells.RemoveAtSwap(Index);
+}
+
+// Update an indexed actor's location, only touching the cells if it has moved into another one
+void AOceanSpatialHash::MoveActor(AActor* Actor, FVector Location)
+{
+	const int32* FoundIndex = ActorIndices.Find(Actor);
+	if (!FoundIndex) return;
+
+	int32 Index = *FoundIndex;
+	Locations[Index] = Location;
+
+	FIntPoint Cell = GetCell(Location);
+	if (Cell != EntryCells[Index])
+	{
+		RemoveFromCell(EntryCells[Index], Index);
+		AddToCell(Cell, Index);
+		EntryCells[Index] = Cell;
+	}
+}
+
+// Mask matching a single kind of actor
+int32 AOceanSpatialHash::GetKindMask(EOceanSpatialKind Kind)
+{
+	return 1 << (int32)Kind;
+}
+
+// Add every entry of a kind in the mask within a radius of a point in a cell to the candidates, keyed by distance squared
+void AOceanSpatialHash::GatherCell(const TArray<int32> &Entries, FVector Centre, float RadiusSquared, int32 KindMask)
+{
+	for (int32 i = 0; i < Entries.Num(); i++)
+	{
+		int32 Index = Entries[i];
+		if (!(KindMask & GetKindMask(Kinds[Index]))) continue;
+
+		float DistanceSquared = FVector::DistSquared(Locations[Index], Centre);
+		if (DistanceSquared <= RadiusSquared)
+		{
+			Candidates.Add(TPair<float, int32>(DistanceSquared, Index));
+		}
+	}
+}
+
+// Copy the candidates into an actor array, nearest first
+int32 AOceanSpatialHash::SortCandidates(int32 MaxCount, TArray<AActor*> &OutActors)
+{
+	Candidates.Sort([](const TPair<float, int32> &A, const TPair<float, int32> &B) { return A.Key < B.Key; });
+
+	int32 NumOut = FMath::Min(Candidates.Num(), MaxCount);
+	OutActors.SetNumUninitialized(NumOut);
+	for (int32 i = 0; i < NumOut; i++)
+	{
+		OutActors[i] = Actors[Candidates[i].Value];
+	}
+	return NumOut;
+}
+
+// Find every actor of a kind in the mask within a radius of a point, nearest first
+int32 AOceanSpatialHash::QueryRadius(FVector Centre, float Radius, int32 KindMask, TArray<AActor*> &OutActors)
+{
+	Candidates.Reset();
+	OutActors.Reset();
+	if (Radius < 0.f || Actors.Num() == 0) return 0;
+
+	FIntPoint MinCell = GetCell(Centre - FVector(Radius));
+	FIntPoint MaxCell = GetCell(Centre + FVector(Radius));
+
+	//a radius covering more cells than are occupied is quicker to check against the occupied cells
+	int64 NumCells = int64(MaxCell.X - MinCell.X + 1) * int64(MaxCell.Y - MinCell.Y + 1);
+	if (NumCells > Cells.Num())
+	{
+		for (auto It = Cells.CreateConstIterator(); It; ++It)
+		{
+			GatherCell(It.Value(), Centre, Radius * Radius, KindMask);
+		}
+	}
+	else
+	{
+		for (int32 X = MinCell.X; X <= MaxCell.X; X++)
+		{
+			for (int32 Y = MinCell.Y; Y <= MaxCell.Y; Y++)
+			{
+				const TArray<int32>* Entries = Cells.Find(FIntPoint(X, Y));
+				if (Entries)
+				{
+					GatherCell(*Entries, Centre, Radius * Radius, KindMask);
+				}
+			}
+		}
+	}
+
+	return SortCandidates(Candidates.Num(), OutActors);
+}
+
+// Find up to a number of the nearest actors of a kind in the mask, no further than a radius from a point, nearest first
+int32 AOceanSpatialHash::QueryNearest(FVector Centre, int32 Count, float MaxRadius, int32 KindMask, TArray<AActor*> &OutActors)
+{
+	Candidates.Reset();
+	OutActors.Reset();
+	if (Count <= 0 || MaxRadius < 0.f || Actors.Num() == 0) return 0;
+
+	//rings of cells further out than the radius can't hold anything in it
+	int32 MaxRing = FMath::CeilToInt(MaxRadius / CellSize) + 1;
+	if (int64(2 * MaxRing + 1) * int64(2 * MaxRing + 1) > Cells.Num())
+	{
+		QueryRadius(Centre, MaxRadius, KindMask, OutActors);
+		OutActors.SetNum(FMath::Min(OutActors.Num(), Count));
+		return OutActors.Num();
+	}
+
+	//search outward a square ring of cells at a time
+	FIntPoint CentreCell = GetCell(Centre);
+	for (int32 Ring = 0; Ring <= MaxRing; Ring++)
+	{
+		//anything in this ring is at least a ring less one cell away, so stop once enough are found closer than that
+		if (Candidates.Num() >= Count)
+		{
+			Candidates.Sort([](const TPair<float, int32> &A, const TPair<float, int32> &B) { return A.Key < B.Key; });
+			float RingDistance = (Ring - 1) * CellSize;
+			if (Candidates[Count - 1].Key <= RingDistance * RingDistance) break;
+		}
+
+		for (int32 X = -Ring; X <= Ring; X++)
+		{
+			//full rows at the top and bottom of the ring, only the ends of the rows between
+			int32 YStep = (X == -Ring || X == Ring) ? 1 : FMath::Max(2 * Ring, 1);
+			for (int32 Y = -Ring; Y <= Ring; Y += YStep)
+			{
+				const TArray<int32>* Entries = Cells.Find(CentreCell + FIntPoint(X, Y));
+				if (Entries)
+				{
+					GatherCell(*Entries, Centre, MaxRadius * MaxRadius, KindMask);
+				}
+			}
+		}
+	}
+
+	return SortCandidates(Count, OutActors);
+}
+
+// Find every actor of a kind in the mask within a radius of a line segment, in order along the segment
+int32 AOceanSpatialHash::QuerySegment(FVector Start, FVector End, float Radius, int32 KindMask, TArray<AActor*> &OutActors)
+{
+	Candidates.Reset();
+	VisitedCells.Reset();
+	OutActors.Reset();
+	if (Radius < 0.f || Actors.Num() == 0) return 0;
+
+	//walk the cells the segment crosses on the ocean plane, and the cells within the radius of each
+	int32 Border = FMath::CeilToInt(Radius / CellSize);
+	FVector2D From(Start.X / CellSize, Start.Y / CellSize);
+	FVector2D Direction = FVector2D(End.X / CellSize, End.Y / CellSize) - From;
+	FIntPoint Cell = GetCell(Start);
+	FIntPoint EndCell = GetCell(End);
+
+	int32 StepX = Direction.X > 0.f ? 1 : -1;
+	int32 StepY = Direction.Y > 0.f ? 1 : -1;
+	float DeltaX = Direction.X != 0.f ? FMath::Abs(1.f / Direction.X) : BIG_NUMBER;
+	float DeltaY = Direction.Y != 0.f ? FMath::Abs(1.f / Direction.Y) : BIG_NUMBER;
+	float NextX = Direction.X != 0.f ? (Direction.X > 0.f ? Cell.X + 1 - From.X : From.X - Cell.X) * DeltaX : BIG_NUMBER;
+	float NextY = Direction.Y != 0.f ? (Direction.Y > 0.f ? Cell.Y + 1 - From.Y : From.Y - Cell.Y) * DeltaY : BIG_NUMBER;
+
+	int32 MaxSteps = FMath::Abs(EndCell.X - Cell.X) + FMath::Abs(EndCell.Y - Cell.Y);
+	for (int32 Step = 0; Step <= MaxSteps; Step++)
+	{
+		for (int32 X = -Border; X <= Border; X++)
+		{
+			for (int32 Y = -Border; Y <= Border; Y++)
+			{
+				VisitedCells.Add(Cell + FIntPoint(X, Y));
+			}
+		}
+
+		if (Cell == EndCell) break;
+
+		//into whichever neighbour the segment reaches first
+		if (NextX < NextY)
+		{
+			NextX += DeltaX;
+			Cell.X += StepX;
+		}
+		else
+		{
+			NextY += DeltaY;
+			Cell.Y += StepY;
+		}
+	}
+
+	//keyed by how far along the segment each actor is
+	FVector Segment = End - Start;
+	float SegmentSizeSquared = FMath::Max(Segment.SizeSquared(), KINDA_SMALL_NUMBER);
+	for (auto It = VisitedCells.CreateConstIterator(); It; ++It)
+	{
+		const TArray<int32>* Entries = Cells.Find(*It);
+		if (!Entries) continue;
+
+		for (int32 i = 0; i < Entries->Num(); i++)
+		{
+			int32 Index = (*Entries)[i];
+			if (!(KindMask & GetKindMask(Kinds[Index]))) continue;
+
+			if (FMath::PointDistToSegment(Locations[Index], Start, End) <= Radius)
+			{
+				Candidates.Add(TPair<float, int32>(((Locations[Index] - Start) | Segment) / SegmentSizeSquared, Index));
+			}
+		}
+	}
+
+	return SortCandidates(Candidates.Num(), OutActors);
+}
+
+// Whether any actor of a kind in the mask is within a radius of a point
+bool AOceanSpatialHash::AnyInRadius(FVector Centre, float Radius, int32 KindMask)
+{
+	if (Radius < 0.f || Actors.Num() == 0) return false;
+
+	FIntPoint MinCell = GetCell(Centre - FVector(Radius));
+	FIntPoint MaxCell = GetCell(Centre + FVector(Radius));
+	for (int32 X = MinCell.X; X <= MaxCell.X; X++)
+	{
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; Y++)
+		{
+			const TArray<int32>* Entries = Cells.Find(FIntPoint(X, Y));
+			if (!Entries) continue;
+
+			for (int32 i = 0; i < Entries->Num(); i++)
+			{
+				int32 Index = (*Entries)[i];
+				if ((KindMask & GetKindMask(Kinds[Index])) && FVector::DistSquared(Locations[Index], Centre) <= Radius * Radius) return true;
+			}
+		}
+	}
+	return false;
+}
+
+int32 AOceanSpatialHash::GetNumActors()
+{
+	return Actors.Num();
+}
@@ -7,8 +7,8 @@
 // Sets default values
 ASkySphere::ASkySphere()
 {
- 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+	//nothing to do per frame
+	PrimaryActorTick.bCanEverTick = false;
 	
 	//sky mesh
 
@@ -26,10 +26,3 @@ void ASkySphere::BeginPlay()
 	
 }
 
-// Called every frame
-void ASkySphere::Tick( float DeltaTime )
-{
-	Super::Tick( DeltaTime );
-
-}
-
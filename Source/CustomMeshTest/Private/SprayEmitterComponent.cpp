@@ -0,0 +1,327 @@
+// Visual only - spray thrown up along a spline by a vessel, simulated natively and drawn as one buffer of camera facing sprites that splash into the waves
+
+#include "CustomMeshTest.h"
+#include "CustomMeshTestGameMode.h"
+#include "WaveManager.h"
+#include "FoamManager.h"
+#include "Classes/Components/SplineComponent.h"
+#include "SprayEmitterComponent.h"
+
+
+// Sets default values for this component's properties
+USprayEmitterComponent::USprayEmitterComponent()
+{
+	bWantsBeginPlay = true;
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+
+	//sprite verts are in world space, so the component stays at the world origin whatever it is attached to
+	bAbsoluteLocation = true;
+	bAbsoluteRotation = true;
+	bAbsoluteScale = true;
+	SetCollisionEnabled(ECollisionEnabled::NoCollision);
+
+	//find material - same as the spray particle system
+
+	static ConstructorHelpers::FObjectFinder<UMaterial> SprayMatClassFinder(TEXT("/Game/Boat/Effects/Materials/FoamSprayMat"));
+	SprayMaterial = SprayMatClassFinder.Object;
+
+	//default spray params
+
+	MaxParticles = 2048;
+	ArcTableSize = 64;
+	Lifetime = 1.5f;
+	Gravity = 981.f;
+	SpriteSize = 15.f;
+	SplashRadius = 60.f;
+	SplashAmount = 0.1f;
+
+	NumParticles = 0;
+	Capacity = 0;
+	NumDrawn = 0;
+	SpritesBuilt = false;
+	SprayEnabled = false;
+}
+
+
+// Called when the game starts
+void USprayEmitterComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	SetWorldLocationAndRotation(FVector::ZeroVector, FRotator::ZeroRotator);
+
+	//off until the vessel uses native spray, the sprite buffer is only built when it is first turned on
+	SetVisibility(false);
+}
+
+
+// Called every frame
+void USprayEmitterComponent::TickComponent( float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction )
+{
+	Super::TickComponent( DeltaTime, TickType, ThisTickFunction );
+
+	if (!SpritesBuilt) return;
+
+	//waves and time for this frame
+	const FOceanContext* Ocean = ACustomMeshTestGameMode::FindOceanContext(this);
+	WaveManager = Ocean ? Ocean->WaveManager : nullptr;
+	FoamManager = Ocean ? Ocean->FoamManager : nullptr;
+
+	IntegrateParticles(DeltaTime);
+	KillParticles(Ocean ? Ocean->Time : GetWorld()->GetTimeSeconds());
+	UpdateSprites();
+}
+
+// Sample a spline into the table particles are emitted from
+void USprayEmitterComponent::BuildArcTable(USplineComponent* Spline)
+{
+	ArcPositions.Reset();
+	ArcNormals.Reset();
+	if (!Spline || !GetOwner()) return;
+
+	//equal distances along the spline, so a random distance is just a table lookup
+	int32 TableSize = FMath::Max(ArcTableSize, 2);
+	float SplineLength = Spline->GetSplineLength();
+	FTransform OwnerTransform = GetOwner()->GetActorTransform();
+	for (int32 i = 0; i < TableSize; i++)
+	{
+		float Distance = SplineLength*i / (TableSize - 1);
+		FVector Position = Spline->GetLocationAtDistanceAlongSpline(Distance, ESplineCoordinateSpace::World);
+		FVector Tangent = Spline->GetTangentAtDistanceAlongSpline(Distance, ESplineCoordinateSpace::World);
+
+		//normal to the spline, same as the particle system spray
+		ArcPositions.Add(OwnerTransform.InverseTransformPosition(Position));
+		ArcNormals.Add(OwnerTransform.InverseTransformVectorNoScale(FRotator(0.f, -90.f, 0.f).RotateVector(Tangent).GetSafeNormal()));
+	}
+}
+
+// Emit particles at random points along the spline, thrown out from it and upwards
+void USprayEmitterComponent::Emit(int32 Count, float MinSpeed, float MaxSpeed)
+{
+	if (ArcPositions.Num() < 2 || !GetOwner()) return;
+
+	FTransform OwnerTransform = GetOwner()->GetActorTransform();
+	Count = FMath::Min(Count, Capacity - NumParticles);
+	for (int32 i = 0; i < Count; i++)
+	{
+		//interpolate the arc table at a random distance along the spline
+		float TablePosition = FMath::FRand()*(ArcPositions.Num() - 1);
+		int32 Index = FMath::Min(FMath::FloorToInt(TablePosition), ArcPositions.Num() - 2);
+		float Alpha = TablePosition - Index;
+		FVector Position = OwnerTransform.TransformPosition(FMath::Lerp(ArcPositions[Index], ArcPositions[Index + 1], Alpha));
+		FVector Velocity = OwnerTransform.TransformVectorNoScale(FMath::Lerp(ArcNormals[Index], ArcNormals[Index + 1], Alpha));
+		Velocity.Z = 1.f;
+		Velocity = Velocity.GetSafeNormal() * FMath::RandRange(MinSpeed, MaxSpeed);
+
+		int32 Particle = NumParticles++;
+		PosX[Particle] = Position.X;
+		PosY[Particle] = Position.Y;
+		PosZ[Particle] = Position.Z;
+		VelX[Particle] = Velocity.X;
+		VelY[Particle] = Velocity.Y;
+		VelZ[Particle] = Velocity.Z;
+		Ages[Particle] = 0.f;
+	}
+}
+
+int32 USprayEmitterComponent::GetNumParticles()
+{
+	return NumParticles;
+}
+
+// Turn the spray on or off - off stops it ticking and hides it, on builds the sprite buffer the first time
+void USprayEmitterComponent::SetSprayEnabled(bool Enabled)
+{
+	if (Enabled == SprayEnabled) return;
+	SprayEnabled = Enabled;
+
+	if (Enabled && !SpritesBuilt)
+	{
+		BuildSprites();
+	}
+	SetComponentTickEnabled(Enabled);
+	SetVisibility(Enabled);
+}
+
+bool USprayEmitterComponent::IsSprayEnabled()
+{
+	return SprayEnabled;
+}
+
+// Create the sprite buffer with room for every particle
+void USprayEmitterComponent::BuildSprites()
+{
+	//whole number of 4 wide vectors for the integration pass
+	Capacity = Align(FMath::Max(MaxParticles, 4), 4);
+
+	PosX.Init(0.f, Capacity);
+	PosY.Init(0.f, Capacity);
+	PosZ.Init(0.f, Capacity);
+	VelX.Init(0.f, Capacity);
+	VelY.Init(0.f, Capacity);
+	VelZ.Init(0.f, Capacity);
+	Ages.Init(0.f, Capacity);
+	Dead.Init(false, Capacity);
+
+	//one quad per particle, corners fixed for the life of the buffer
+	TArray<int32> Tris;
+	TArray<FVector2D> UV0;
+	Tris.Reserve(Capacity * 6);
+	UV0.Reserve(Capacity * 4);
+	for (int32 i = 0; i < Capacity; i++)
+	{
+		Tris.Add(i * 4);
+		Tris.Add(i * 4 + 1);
+		Tris.Add(i * 4 + 2);
+
+		Tris.Add(i * 4);
+		Tris.Add(i * 4 + 2);
+		Tris.Add(i * 4 + 3);
+
+		UV0.Add(FVector2D(0.f, 0.f));
+		UV0.Add(FVector2D(1.f, 0.f));
+		UV0.Add(FVector2D(1.f, 1.f));
+		UV0.Add(FVector2D(0.f, 1.f));
+	}
+
+	Verts.Init(FVector::ZeroVector, Capacity * 4);
+	Normals.Init(FVector::UpVector, Capacity * 4);
+	Colors.Init(FColor(255, 255, 255, 0), Capacity * 4);
+
+	TArray<FProcMeshTangent> Tangents;
+	CreateMeshSection(0, Verts, Tris, Normals, UV0, Colors, Tangents, false);
+	if (SprayMaterial)
+	{
+		SetMaterial(0, SprayMaterial);
+	}
+	SpritesBuilt = true;
+	UE_LOG(LogTemp, Log, TEXT("Spray sprite buffer built for %d particles in one draw."), Capacity);
+}
+
+// Move every particle and age it, 4 particles at a time
+void USprayEmitterComponent::IntegrateParticles(float DeltaTime)
+{
+	VectorRegister DeltaTimeVector = VectorSetFloat1(DeltaTime);
+	VectorRegister GravityStep = VectorSetFloat1(-Gravity*DeltaTime);
+
+	//arrays are padded to whole vectors so the last partial vector stays in bounds
+	for (int32 i = 0; i < NumParticles; i += 4)
+	{
+		VectorRegister NewVelZ = VectorAdd(VectorLoad(&VelZ[i]), GravityStep);
+		VectorStore(NewVelZ, &VelZ[i]);
+
+		VectorStore(VectorMultiplyAdd(VectorLoad(&VelX[i]), DeltaTimeVector, VectorLoad(&PosX[i])), &PosX[i]);
+		VectorStore(VectorMultiplyAdd(VectorLoad(&VelY[i]), DeltaTimeVector, VectorLoad(&PosY[i])), &PosY[i]);
+		VectorStore(VectorMultiplyAdd(NewVelZ, DeltaTimeVector, VectorLoad(&PosZ[i])), &PosZ[i]);
+		VectorStore(VectorAdd(VectorLoad(&Ages[i]), DeltaTimeVector), &Ages[i]);
+	}
+}
+
+// Kill particles at the end of their life or that have fallen into the waves, splashing foam where they land
+void USprayEmitterComponent::KillParticles(float Time)
+{
+	//only falling particles low enough to reach a wave need the surface
+	float MaxHeight = WaveManager ? WaveManager->GetMaxWaveHeight() : 0.f;
+	QueryPositions.Reset();
+	QueryParticles.Reset();
+	for (int32 i = 0; i < NumParticles; i++)
+	{
+		Dead[i] = Ages[i] > Lifetime;
+		if (!Dead[i] && WaveManager && VelZ[i] < 0.f && PosZ[i] < MaxHeight)
+		{
+			QueryPositions.Add(FVector2D(PosX[i], PosY[i]));
+			QueryParticles.Add(i);
+		}
+	}
+
+	//spray is short lived and small, so the surface height at its position is close enough without undoing horizontal displacement
+	if (QueryPositions.Num() > 0)
+	{
+		WaveManager->GetWaveDisplacementNormalBatch(QueryPositions, Time, Displacements, WaveNormals);
+		for (int32 i = 0; i < QueryParticles.Num(); i++)
+		{
+			int32 Particle = QueryParticles[i];
+			if (PosZ[Particle] <= Displacements[i].Z)
+			{
+				Dead[Particle] = true;
+				if (FoamManager)
+				{
+					FoamManager->SplatFoamMap(FVector(PosX[Particle], PosY[Particle], 0.f), SplashRadius, SplashAmount);
+				}
+			}
+		}
+	}
+
+	//backwards so swapped in particles have already been checked
+	for (int32 i = NumParticles - 1; i >= 0; i--)
+	{
+		if (Dead[i])
+		{
+			RemoveParticle(i);
+		}
+	}
+}
+
+// Remove a particle by swapping the last particle into its place
+void USprayEmitterComponent::RemoveParticle(int32 Index)
+{
+	int32 Last = --NumParticles;
+	PosX[Index] = PosX[Last];
+	PosY[Index] = PosY[Last];
+	PosZ[Index] = PosZ[Last];
+	VelX[Index] = VelX[Last];
+	VelY[Index] = VelY[Last];
+	VelZ[Index] = VelZ[Last];
+	Ages[Index] = Ages[Last];
+	Dead[Index] = Dead[Last];
+}
+
+// Build a camera facing quad for every live particle
+void USprayEmitterComponent::UpdateSprites()
+{
+	//nothing drawn last frame and nothing to draw now
+	if (NumParticles == 0 && NumDrawn == 0) return;
+
+	FVector CameraRight = FVector::RightVector;
+	FVector CameraUp = FVector::UpVector;
+	FVector CameraBack = -FVector::ForwardVector;
+	APlayerCameraManager* CameraManager = UGameplayStatics::GetPlayerCameraManager(this, 0);
+	if (CameraManager)
+	{
+		FRotationMatrix CameraMatrix(CameraManager->GetCameraRotation());
+		CameraRight = CameraMatrix.GetScaledAxis(EAxis::Y);
+		CameraUp = CameraMatrix.GetScaledAxis(EAxis::Z);
+		CameraBack = -CameraMatrix.GetScaledAxis(EAxis::X);
+	}
+	FVector Corner0 = (-CameraRight + CameraUp)*SpriteSize;
+	FVector Corner1 = (CameraRight + CameraUp)*SpriteSize;
+
+	for (int32 i = 0; i < NumParticles; i++)
+	{
+		FVector Centre = FVector(PosX[i], PosY[i], PosZ[i]);
+		FColor SpriteColor = FColor(255, 255, 255, (uint8)FMath::Clamp(FMath::RoundToInt((1.f - Ages[i] / Lifetime) * 255.f), 0, 255));
+
+		Verts[i * 4] = Centre + Corner0;
+		Verts[i * 4 + 1] = Centre + Corner1;
+		Verts[i * 4 + 2] = Centre - Corner0;
+		Verts[i * 4 + 3] = Centre - Corner1;
+		for (int32 j = 0; j < 4; j++)
+		{
+			Normals[i * 4 + j] = CameraBack;
+			Colors[i * 4 + j] = SpriteColor;
+		}
+	}
+
+	//sprites no longer used collapse to a point
+	for (int32 i = NumParticles * 4; i < NumDrawn * 4; i++)
+	{
+		Verts[i] = FVector::ZeroVector;
+		Colors[i] = FColor(255, 255, 255, 0);
+	}
+	NumDrawn = NumParticles;
+
+	TArray<FVector2D> UV0;
+	TArray<FProcMeshTangent> Tangents;
+	UpdateMeshSection(0, Verts, Normals, UV0, Colors, Tangents);
+}
@@ -0,0 +1,59 @@
+// Headless test of the foam accumulation map - splats, decays and scrolls a small map and checks the packed texels that would be uploaded
+
+#include "CustomMeshTest.h"
+#include "FoamAccumulationMap.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFoamAccumulationMapTest, "CustomMeshTest.FoamAccumulationMap", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FFoamAccumulationMapTest::RunTest(const FString& Parameters)
+{
+	//8 texels of 100 units, window from world texel -4 to 3
+	FFoamAccumulationMap Map;
+	Map.Init(8, 800.f);
+	Map.Recentre(FVector2D(0.f, 0.f));
+	TestEqual(TEXT("Resolution"), Map.GetResolution(), 8);
+
+	//packed index of a world texel in the wrapped map
+	auto PackedIndex = [](int32 WorldTexelX, int32 WorldTexelY)
+	{
+		return ((WorldTexelY % 8 + 8) % 8) * 8 + (WorldTexelX % 8 + 8) % 8;
+	};
+
+	//splat centred on world texel 0,0 with a radius of 2 texels - full at the centre, half a texel out, none two texels out
+	Map.Splat(FVector2D(50.f, 50.f), 200.f, 1.f);
+	const TArray<uint8>& Splatted = Map.PackTexels();
+	TestEqual(TEXT("Splat centre"), (int32)Splatted[PackedIndex(0, 0)], 255);
+	TestEqual(TEXT("Splat falloff"), (int32)Splatted[PackedIndex(1, 0)], 128);
+	TestEqual(TEXT("Splat edge"), (int32)Splatted[PackedIndex(2, 0)], 0);
+	TestEqual(TEXT("Splat outside"), (int32)Splatted[PackedIndex(-3, -3)], 0);
+
+	//decay halves every texel
+	Map.Decay(0.5f);
+	const TArray<uint8>& Decayed = Map.PackTexels();
+	TestEqual(TEXT("Decayed centre"), (int32)Decayed[PackedIndex(0, 0)], 128);
+	TestEqual(TEXT("Decayed falloff"), (int32)Decayed[PackedIndex(1, 0)], 64);
+
+	//scrolling 3 texels keeps foam still in the window
+	Map.Recentre(FVector2D(300.f, 0.f));
+	const TArray<uint8>& Scrolled = Map.PackTexels();
+	TestEqual(TEXT("Scrolled kept centre"), (int32)Scrolled[PackedIndex(0, 0)], 128);
+	TestEqual(TEXT("Scrolled kept falloff"), (int32)Scrolled[PackedIndex(1, 0)], 64);
+
+	//scrolling 3 more moves world texels 0 and 1 out, the texels that wrap in for 8 and 9 start clear
+	Map.Recentre(FVector2D(600.f, 0.f));
+	const TArray<uint8>& Wrapped = Map.PackTexels();
+	TestEqual(TEXT("Wrapped texel cleared"), (int32)Wrapped[PackedIndex(8, 0)], 0);
+	TestEqual(TEXT("Wrapped texel cleared next"), (int32)Wrapped[PackedIndex(9, 0)], 0);
+	TestEqual(TEXT("Scrolled out reads empty"), Map.GetIntensityAt(FVector2D(50.f, 50.f)), 0.f);
+
+	//foam splatted on a wrapped texel lands in the reused slot
+	Map.Splat(FVector2D(850.f, 50.f), 200.f, 1.f);
+	const TArray<uint8>& Resplatted = Map.PackTexels();
+	TestEqual(TEXT("Wrapped splat"), (int32)Resplatted[PackedIndex(8, 0)], 255);
+
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,238 @@
+// Visual only - wake left behind a vessel, a ring buffer of cross sections drawn as one ribbon mesh that follows the waves and fades with age
+
+#include "CustomMeshTest.h"
+#include "CustomMeshTestGameMode.h"
+#include "WaveManager.h"
+#include "Boat.h"
+#include "WakeRibbonComponent.h"
+
+
+// Sets default values for this component's properties
+UWakeRibbonComponent::UWakeRibbonComponent()
+{
+	bWantsBeginPlay = true;
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+
+	//ribbon verts are in world space, so the component stays at the world origin whatever it is attached to
+	bAbsoluteLocation = true;
+	bAbsoluteRotation = true;
+	bAbsoluteScale = true;
+	SetCollisionEnabled(ECollisionEnabled::NoCollision);
+
+	//find material
+
+	static ConstructorHelpers::FObjectFinder<UMaterial> WakeMatClassFinder(TEXT("/Game/Boat/Effects/Materials/FoamDecalMat"));
+	WakeMaterial = WakeMatClassFinder.Object;
+
+	//default wake params
+
+	bEmitting = true;
+	RingSize = 48;
+	SectionSpacing = 150.f;
+	WakeOffset = FVector(-100.f, 0.f, 0.f);
+	StartHalfWidth = 60.f;
+	SpreadRate = 40.f;
+	Lifetime = 6.f;
+	UVLength = 1000.f;
+
+	NewestSection = 0;
+	NumSections = 0;
+	WakeDistance = 0.f;
+	WasEmitting = false;
+	RibbonBuilt = false;
+	WakeEnabled = false;
+}
+
+
+// Called when the game starts
+void UWakeRibbonComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	SetWorldLocationAndRotation(FVector::ZeroVector, FRotator::ZeroRotator);
+
+	//off until the boat wants a wake, the ribbon is only built when it is first turned on
+	ABoat* Boat = Cast<ABoat>(GetOwner());
+	if (Boat && Boat->bWakeRibbon)
+	{
+		SetWakeEnabled(true);
+	}
+}
+
+
+// Called every frame
+void UWakeRibbonComponent::TickComponent( float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction )
+{
+	Super::TickComponent( DeltaTime, TickType, ThisTickFunction );
+
+	if (!RibbonBuilt || !GetOwner()) return;
+
+	//waves and time for this frame
+	const FOceanContext* Ocean = ACustomMeshTestGameMode::FindOceanContext(this);
+	WaveManager = Ocean ? Ocean->WaveManager : nullptr;
+	if (!WaveManager) return;
+
+	float Time = Ocean->Time;
+
+	//head of the wake behind the vessel, kept flat on the ocean plane
+	FVector HeadLocation = GetOwner()->GetActorTransform().TransformPosition(WakeOffset);
+	FVector2D HeadCentre = FVector2D(HeadLocation.X, HeadLocation.Y);
+	FVector2D HeadRight = FVector2D(GetOwner()->GetActorRightVector().X, GetOwner()->GetActorRightVector().Y).GetSafeNormal();
+
+	//new cross section every spacing travelled, gap sections either side of time spent not emitting
+	if (bEmitting != WasEmitting)
+	{
+		AddCrossSection(HeadCentre, HeadRight, true, Time);
+		WasEmitting = bEmitting;
+	}
+	else if (bEmitting && (FVector2D::Distance(HeadCentre, SectionCentres[NewestSection]) >= SectionSpacing))
+	{
+		AddCrossSection(HeadCentre, HeadRight, false, Time);
+	}
+
+	//slot 0 follows the head, the rest are the ring from newest to oldest that are still alive
+	int32 NumSlots = 1;
+	while (NumSlots <= NumSections && Time - SectionTimes[(NewestSection - (NumSlots - 1) + RingSize) % RingSize] < Lifetime)
+	{
+		NumSlots++;
+	}
+
+	//every live vert queried against the waves in one batch
+	QueryPositions.SetNumUninitialized(NumSlots * 2);
+	for (int32 i = 0; i < NumSlots; i++)
+	{
+		FVector2D Centre = HeadCentre;
+		FVector2D Right = HeadRight;
+		float HalfWidth = StartHalfWidth;
+		if (i > 0)
+		{
+			int32 Section = (NewestSection - (i - 1) + RingSize) % RingSize;
+			Centre = SectionCentres[Section];
+			Right = SectionRights[Section];
+			HalfWidth += SpreadRate * (Time - SectionTimes[Section]);
+		}
+		QueryPositions[i * 2] = Centre - Right * HalfWidth;
+		QueryPositions[i * 2 + 1] = Centre + Right * HalfWidth;
+	}
+	WaveManager->GetWaveDisplacementNormalBatch(QueryPositions, Time, Displacements, WaveNormals);
+
+	for (int32 i = 0; i < NumSlots; i++)
+	{
+		float V = WakeDistance + FVector2D::Distance(HeadCentre, SectionCentres[NewestSection]);
+		float Alpha = bEmitting ? 1.f : 0.f;
+		if (i > 0)
+		{
+			int32 Section = (NewestSection - (i - 1) + RingSize) % RingSize;
+			V = SectionDistances[Section];
+			Alpha = SectionGaps[Section] ? 0.f : FMath::Clamp(1.f - (Time - SectionTimes[Section]) / Lifetime, 0.f, 1.f);
+		}
+		FColor SlotColor = FColor(255, 255, 255, (uint8)FMath::RoundToInt(Alpha * 255.f));
+
+		for (int32 j = 0; j < 2; j++)
+		{
+			int32 Vert = i * 2 + j;
+			Verts[Vert] = FVector(QueryPositions[Vert].X, QueryPositions[Vert].Y, 0.f) + Displacements[Vert];
+			Normals[Vert] = WaveNormals[Vert];
+			UV0[Vert] = FVector2D(j, V / UVLength);
+			Colors[Vert] = SlotColor;
+		}
+	}
+
+	//unused slots collapse onto the end of the ribbon
+	for (int32 i = NumSlots * 2; i < Verts.Num(); i++)
+	{
+		Verts[i] = Verts[NumSlots * 2 - 1];
+		Colors[i] = FColor(255, 255, 255, 0);
+	}
+
+	TArray<FProcMeshTangent> Tangents;
+	UpdateMeshSection(0, Verts, Normals, UV0, Colors, Tangents);
+}
+
+// Turn the whole ribbon on or off - off stops it ticking and hides it, on starts a fresh wake and builds the ribbon the first time
+void UWakeRibbonComponent::SetWakeEnabled(bool Enabled)
+{
+	if (Enabled == WakeEnabled) return;
+	WakeEnabled = Enabled;
+
+	//old cross sections would join the new wake to where the old one ended
+	NumSections = 0;
+	WasEmitting = false;
+
+	SetComponentTickEnabled(Enabled);
+	if (RibbonBuilt)
+	{
+		SetMeshSectionVisible(0, Enabled);
+	}
+	else if (Enabled)
+	{
+		BuildRibbon();
+	}
+}
+
+bool UWakeRibbonComponent::IsWakeEnabled()
+{
+	return WakeEnabled;
+}
+
+// Create the ribbon mesh section with room for every cross section in the ring
+void UWakeRibbonComponent::BuildRibbon()
+{
+	RingSize = FMath::Max(RingSize, 2);
+
+	SectionCentres.Init(FVector2D::ZeroVector, RingSize);
+	SectionRights.Init(FVector2D::ZeroVector, RingSize);
+	SectionTimes.Init(0.f, RingSize);
+	SectionDistances.Init(0.f, RingSize);
+	SectionGaps.Init(true, RingSize);
+
+	//head slot plus one slot per cross section, two verts each
+	int32 NumVerts = (RingSize + 1) * 2;
+	Verts.Init(FVector::ZeroVector, NumVerts);
+	Normals.Init(FVector::UpVector, NumVerts);
+	UV0.Init(FVector2D::ZeroVector, NumVerts);
+	Colors.Init(FColor(255, 255, 255, 0), NumVerts);
+
+	//strip of quads between neighbouring slots, fixed for the life of the ribbon
+	TArray<int32> Tris;
+	Tris.Reserve(RingSize * 6);
+	for (int32 i = 0; i < RingSize; i++)
+	{
+		Tris.Add(i * 2);
+		Tris.Add(i * 2 + 2);
+		Tris.Add(i * 2 + 1);
+
+		Tris.Add(i * 2 + 1);
+		Tris.Add(i * 2 + 2);
+		Tris.Add(i * 2 + 3);
+	}
+
+	TArray<FProcMeshTangent> Tangents;
+	CreateMeshSection(0, Verts, Tris, Normals, UV0, Colors, Tangents, false);
+	SetMeshSectionVisible(0, WakeEnabled);
+	if (WakeMaterial)
+	{
+		SetMaterial(0, WakeMaterial);
+	}
+	RibbonBuilt = true;
+	UE_LOG(LogTemp, Log, TEXT("Wake ribbon built, %d cross sections, %d tris in one draw."), RingSize, Tris.Num() / 3);
+}
+
+// Add a cross section as the newest in the ring
+void UWakeRibbonComponent::AddCrossSection(FVector2D Centre, FVector2D Right, bool Gap, float Time)
+{
+	if (NumSections > 0)
+	{
+		WakeDistance += FVector2D::Distance(Centre, SectionCentres[NewestSection]);
+	}
+
+	NewestSection = (NewestSection + 1) % RingSize;
+	NumSections = FMath::Min(NumSections + 1, RingSize);
+
+	SectionCentres[NewestSection] = Centre;
+	SectionRights[NewestSection] = Right;
+	SectionTimes[NewestSection] = Time;
+	SectionDistances[NewestSection] = WakeDistance;
+	SectionGaps[NewestSection] = Gap;
+}
@@ -17,6 +17,37 @@ void UWaveForm::GetWaveDisplacementNormal(FVector2D Position, float Time, FVecto
 	return;
 }
 
+// Largest vertical displacement the wave can produce
+float UWaveForm::GetMaxHeight()
+{
+	return 0.f;
+}
+
+// Whether the wave's phase can be split into a part depending only on position and a part depending only on time
+bool UWaveForm::SupportsPhaseCache()
+{
+	return false;
+}
+
+// Find the part of the wave's phase that depends only on position
+float UWaveForm::GetSpatialPhase(FVector2D Position)
+{
+	return 0.f;
+}
+
+// Find the part of the wave's phase that depends only on time
+float UWaveForm::GetTimePhase(float Time)
+{
+	return 0.f;
+}
+
+// Find the wave's displacement and normal given the cos and sin of its total phase
+void UWaveForm::GetWaveDisplacementNormalFromPhase(float CosPhase, float SinPhase, FVector &Displacement, FVector &Normal)
+{
+	Displacement = FVector::ZeroVector;
+	Normal = FVector::ZeroVector;
+}
+
 // Called after the wave is created
 void UWaveForm::Init(UWaveManager * Manager)
 {
@@ -5,12 +5,23 @@
 #include "WaveManager.h"
 
 
+// Sets default values
+UWaveManager::UWaveManager()
+{
+	//surface query params
+	HeightIterations = 3;
+	TraceStepSize = 100.f;
+	TraceMaxSteps = 1024;
+	TraceRefineIterations = 6;
+}
+
 // Add a wave form to be used
 void UWaveManager::AddWaveForm(UWaveForm * WaveFormAdd)
 {
 	if (!WaveFormAdd) return;
 	WaveFormAdd->Init(this);
 	WaveForms.Add(WaveFormAdd);
+	WaveVersion++;
 }
 
 
@@ -19,6 +30,7 @@ void UWaveManager::RemoveWaveForm(UWaveForm * WaveFormRemove)
 {
 	if (!WaveFormRemove) return;
 	if (!WaveForms.Remove(WaveFormRemove)) return;
+	WaveVersion++;
 	if (!WaveFormRemove->IsValidLowLevel()) return;
 	WaveFormRemove->ConditionalBeginDestroy();
 	WaveFormRemove = NULL;
@@ -51,3 +63,276 @@ void UWaveManager::GetWaveDisplacementNormal(FVector2D Position, float Time, FVe
 	//correct normal
 	Normal = FVector(0 - TotalNormal.X, 0 - TotalNormal.Y, 1 - TotalNormal.Z);
 }
+
+int32 UWaveManager::GetNumWaveForms()
+{
+	return WaveForms.Num();
+}
+
+int32 UWaveManager::GetWaveVersion()
+{
+	return WaveVersion;
+}
+
+// Check every wave form can split its phase into a spatial part and a time part
+bool UWaveManager::CanCachePhase()
+{
+	for (int32 i = 0; i < WaveForms.Num(); i++)
+	{
+		if (WaveForms[i] && !WaveForms[i]->SupportsPhaseCache()) return false;
+	}
+	return true;
+}
+
+// Find cos and sin of every wave's spatial phase at each position - table is position major (Position * NumWaveForms + Wave)
+bool UWaveManager::CacheSpatialPhase(const TArray<FVector2D> &Positions, TArray<FVector2D> &PhaseTable)
+{
+	if (!CanCachePhase()) return false;
+
+	int32 NumWaves = WaveForms.Num();
+	PhaseTable.SetNumUninitialized(Positions.Num() * NumWaves);
+
+	for (int32 i = 0; i < Positions.Num(); i++)
+	{
+		for (int32 j = 0; j < NumWaves; j++)
+		{
+			FVector2D &Entry = PhaseTable[i * NumWaves + j];
+
+			//missing wave forms contribute nothing, so store a zero phase
+			if (!WaveForms[j])
+			{
+				Entry = FVector2D(1.f, 0.f);
+				continue;
+			}
+
+			FMath::SinCos(&Entry.Y, &Entry.X, WaveForms[j]->GetSpatialPhase(Positions[i]));
+		}
+	}
+	return true;
+}
+
+// Find cos and sin of every wave's time phase
+void UWaveManager::GetTimePhase(float Time, TArray<FVector2D> &TimePhase)
+{
+	TimePhase.SetNumUninitialized(WaveForms.Num());
+	for (int32 i = 0; i < WaveForms.Num(); i++)
+	{
+		if (!WaveForms[i])
+		{
+			TimePhase[i] = FVector2D(1.f, 0.f);
+			continue;
+		}
+		FMath::SinCos(&TimePhase[i].Y, &TimePhase[i].X, WaveForms[i]->GetTimePhase(Time));
+	}
+}
+
+// Find the overall displacement and normal of all waves from the cached spatial phase of one position, rotated by the time phase
+void UWaveManager::GetWaveDisplacementNormalCached(const FVector2D* SpatialPhase, const TArray<FVector2D> &TimePhase, FVector &Displacement, FVector &Normal)
+{
+	FVector TotalDisplacement = FVector::ZeroVector;
+	FVector TotalNormal = FVector::ZeroVector;
+
+	//for all wave forms
+	for (int32 i = 0; i < WaveForms.Num(); i++)
+	{
+		if (WaveForms[i])
+		{
+			//rotate spatial phase by time phase - cos(a+b) and sin(a+b) without any trig
+			float c = SpatialPhase[i].X * TimePhase[i].X - SpatialPhase[i].Y * TimePhase[i].Y;
+			float s = SpatialPhase[i].Y * TimePhase[i].X + SpatialPhase[i].X * TimePhase[i].Y;
+
+			FVector AdditionalDisplacement;
+			FVector AdditionalNormal;
+
+			//add displacement and normal of this wave
+			WaveForms[i]->GetWaveDisplacementNormalFromPhase(c, s, AdditionalDisplacement, AdditionalNormal);
+			TotalDisplacement += AdditionalDisplacement;
+			TotalNormal += AdditionalNormal;
+		}
+	}
+
+	Displacement = TotalDisplacement;
+
+	//correct normal
+	Normal = FVector(0 - TotalNormal.X, 0 - TotalNormal.Y, 1 - TotalNormal.Z);
+}
+
+// Find the height and normal of the wave surface directly above/below a world position, undoing the horizontal displacement of the waves
+void UWaveManager::GetWaveHeightNormal(FVector2D Position, float Time, float &Height, FVector &Normal)
+{
+	FVector Displacement;
+
+	//waves move points sideways as well as up, so find the undisplaced point that ends up over this position
+	FVector2D SamplePosition = Position;
+	for (int32 i = 0; i < HeightIterations; i++)
+	{
+		GetWaveDisplacementNormal(SamplePosition, Time, Displacement, Normal);
+		SamplePosition = Position - FVector2D(Displacement.X, Displacement.Y);
+	}
+
+	GetWaveDisplacementNormal(SamplePosition, Time, Displacement, Normal);
+	Height = Displacement.Z;
+}
+
+// Find the height of the wave surface directly above/below a world position
+float UWaveManager::GetWaveHeight(FVector2D Position, float Time)
+{
+	float Height;
+	FVector Normal;
+	GetWaveHeightNormal(Position, Time, Height, Normal);
+	return Height;
+}
+
+// Find the displacement and normal of all waves at many positions at once, one wave form at a time over every position
+void UWaveManager::GetWaveDisplacementNormalBatch(const TArray<FVector2D> &Positions, float Time, TArray<FVector> &Displacements, TArray<FVector> &Normals)
+{
+	int32 NumPositions = Positions.Num();
+	Displacements.Init(FVector::ZeroVector, NumPositions);
+	Normals.Init(FVector::ZeroVector, NumPositions);
+
+	//for all wave forms, over every position while that wave form's parameters are hot
+	for (int32 i = 0; i < WaveForms.Num(); i++)
+	{
+		if (WaveForms[i])
+		{
+			for (int32 j = 0; j < NumPositions; j++)
+			{
+				FVector AdditionalDisplacement;
+				FVector AdditionalNormal;
+
+				//add displacement and normal of this wave
+				WaveForms[i]->GetWaveDisplacementNormal(Positions[j], Time, AdditionalDisplacement, AdditionalNormal);
+				Displacements[j] += AdditionalDisplacement;
+				Normals[j] += AdditionalNormal;
+			}
+		}
+	}
+
+	//correct normals
+	for (int32 j = 0; j < NumPositions; j++)
+	{
+		Normals[j] = FVector(0 - Normals[j].X, 0 - Normals[j].Y, 1 - Normals[j].Z);
+	}
+}
+
+// Find the height and normal of the wave surface directly above/below many world positions at once
+void UWaveManager::GetWaveHeightNormalBatch(const TArray<FVector2D> &Positions, float Time, TArray<float> &Heights, TArray<FVector> &Normals)
+{
+	int32 NumPositions = Positions.Num();
+	TArray<FVector2D> SamplePositions = Positions;
+	TArray<FVector> Displacements;
+
+	//same fixed point iteration as a single query, every position stepped together
+	for (int32 i = 0; i < HeightIterations; i++)
+	{
+		GetWaveDisplacementNormalBatch(SamplePositions, Time, Displacements, Normals);
+		for (int32 j = 0; j < NumPositions; j++)
+		{
+			SamplePositions[j] = Positions[j] - FVector2D(Displacements[j].X, Displacements[j].Y);
+		}
+	}
+
+	GetWaveDisplacementNormalBatch(SamplePositions, Time, Displacements, Normals);
+	Heights.SetNumUninitialized(NumPositions);
+	for (int32 j = 0; j < NumPositions; j++)
+	{
+		Heights[j] = Displacements[j].Z;
+	}
+}
+
+// Largest height the combined waves can reach
+float UWaveManager::GetMaxWaveHeight()
+{
+	float MaxHeight = 0.f;
+	for (int32 i = 0; i < WaveForms.Num(); i++)
+	{
+		if (WaveForms[i])
+		{
+			MaxHeight += WaveForms[i]->GetMaxHeight();
+		}
+	}
+	return MaxHeight;
+}
+
+// Find where a line first crosses the wave surface, by marching along it and refining the crossing
+bool UWaveManager::LineTraceWaves(FVector Start, FVector End, float Time, FVector &HitLocation, FVector &HitNormal)
+{
+	FVector Line = End - Start;
+	float MaxHeight = GetMaxWaveHeight();
+
+	//line entirely above the highest possible wave can't hit
+	if (Start.Z > MaxHeight && End.Z > MaxHeight) return false;
+
+	//height of the line above the wave surface at a fraction along the line
+	auto HeightAboveWaves = [&](float Alpha, FVector &OutNormal)
+	{
+		FVector Point = Start + Line * Alpha;
+		float WaveHeight;
+		GetWaveHeightNormal(FVector2D(Point.X, Point.Y), Time, WaveHeight, OutNormal);
+		return Point.Z - WaveHeight;
+	};
+
+	//only the part of the line between the highest crest and the lowest trough can cross the surface, padded so flat water still has some
+	float Slab = MaxHeight + 1.f;
+	float Enter = 0.f;
+	float Exit = 1.f;
+	if (Line.Z != 0.f)
+	{
+		float CrestAlpha = (Slab - Start.Z) / Line.Z;
+		float TroughAlpha = (-Slab - Start.Z) / Line.Z;
+		Enter = FMath::Max(FMath::Min(CrestAlpha, TroughAlpha), 0.f);
+		Exit = FMath::Min(FMath::Max(CrestAlpha, TroughAlpha), 1.f);
+	}
+	else if (Start.Z < -Slab)
+	{
+		return false;
+	}
+	if (Enter >= Exit) return false;
+
+	FVector Normal;
+	float PrevAlpha = Enter;
+	float PrevHeight = HeightAboveWaves(Enter, Normal);
+
+	//march along the line until it drops from above to below the surface - starting underwater is not a hit, the line must enter the waves
+	//steps are no longer than the step size however long the line, the step cap only guards against huge lines
+	int32 Steps = FMath::Clamp(FMath::CeilToInt(Line.Size() * (Exit - Enter) / FMath::Max(TraceStepSize, 1.f)), 1, FMath::Max(TraceMaxSteps, 1));
+	for (int32 i = 1; i <= Steps; i++)
+	{
+		float Alpha = Enter + (Exit - Enter) * i / Steps;
+
+		float Height = HeightAboveWaves(Alpha, Normal);
+		if (Height <= 0.f && PrevHeight > 0.f)
+		{
+			//refine the crossing between the last point above and this point below the surface (regula falsi)
+			float AboveAlpha = PrevAlpha;
+			float AboveHeight = PrevHeight;
+			float BelowAlpha = Alpha;
+			float BelowHeight = Height;
+			float HitAlpha = Alpha;
+			for (int32 j = 0; j < TraceRefineIterations; j++)
+			{
+				HitAlpha = AboveAlpha + (BelowAlpha - AboveAlpha) * AboveHeight / (AboveHeight - BelowHeight);
+				float HitHeight = HeightAboveWaves(HitAlpha, Normal);
+				if (HitHeight > 0.f)
+				{
+					AboveAlpha = HitAlpha;
+					AboveHeight = HitHeight;
+				}
+				else
+				{
+					BelowAlpha = HitAlpha;
+					BelowHeight = HitHeight;
+				}
+			}
+
+			HitLocation = Start + Line * HitAlpha;
+			HitNormal = Normal.GetSafeNormal();
+			return true;
+		}
+
+		PrevAlpha = Alpha;
+		PrevHeight = Height;
+	}
+
+	return false;
+}
@@ -5,6 +5,9 @@
 #include "GameFramework/Pawn.h"
 #include "Boat.generated.h"
 
+//lens beam landing on a buoy or vessel, broadcast every frame it stays on one
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FLensBeamHitSignature, AActor*, HitActor, FVector, HitLocation, float, DeltaTime);
+
 UCLASS()
 class CUSTOMMESHTEST_API ABoat : public APawn
 {
@@ -32,8 +35,24 @@ private:
 	// Handle camera positioning
 	void HandleCamera(float DeltaTime);
 
-	//waves
-	class UWaveManager* WaveManager;
+	// Handle lens beam hits
+	void HandleLensBeam(float DeltaTime);
+
+	//game foam manager
+	class AFoamManager* FoamManager;
+
+	//camera boom trace started last frame and the fraction of the arm it left clear
+	FTraceHandle CameraTraceHandle;
+
+	float CameraArmFraction;
+
+	//near plane points kept out of the waves
+
+	TArray<FVector2D> CameraSamplePositions;
+
+	TArray<float> CameraSampleHeights;
+
+	TArray<FVector> CameraSampleNormals;
 
 	//sails
 
@@ -73,6 +92,18 @@ private:
 
 	bool LensFire;
 
+	//where the lens beam ends this frame - on a target, on the waves or at full range - and the buoy or vessel it is on
+
+	FVector LensBeamEnd;
+
+	AActor* LensBeamHitActor;
+
+	//actors along the beam from the spatial hash
+	TArray<AActor*> LensBeamTargets;
+
+	//game ocean spatial hash
+	class AOceanSpatialHash* SpatialHash;
+
 	//dynamic materials
 
 	UMaterial* SailMaterial;
@@ -106,6 +137,12 @@ protected:
 	UPROPERTY(EditAnywhere, Category = Components)
 	class USplineComponent* FoamSpline;
 
+	UPROPERTY(EditAnywhere, Category = Components)
+	class UWakeRibbonComponent* WakeRibbon;
+
+	UPROPERTY(EditAnywhere, Category = Components)
+	class USprayEmitterComponent* SprayEmitter;
+
 	UPROPERTY(EditAnywhere, Category = Components)
 	class UCameraComponent* CameraComp;
 
@@ -174,6 +211,16 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Lens)
 	float LensResist;
 
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Lens)
+	float LensBeamRange;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Lens)
+	float LensBeamTargetReach;
+
+	// Called every frame the lens beam is on a buoy or vessel
+	UPROPERTY(BlueprintAssignable, Category = Lens)
+	FLensBeamHitSignature OnLensBeamHit;
+
 	//touch location parameters
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = TouchLocations)
@@ -217,6 +264,10 @@ public:
 
 	//foam particle parameters
 
+	//wake ribbon needs a wake material that fades by vertex colour A, trail of foam decals until there is one
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Foam)
+	bool bWakeRibbon;
+
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Foam)
 	float FoamInterval;
 
@@ -226,6 +277,10 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Foam)
 	float FoamOffset;
 
+	//native spray needs the spray material to fade by vertex colour A as well as particle colour, spray particle system until it does
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Foam)
+	bool bNativeSpray;
+
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Foam)
 	float SprayAmount;
 
@@ -238,6 +293,20 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Foam)
 	TArray<FVector> SprayCurvePoints;
 
+	//foam map splat parameters
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = FoamMap)
+	float FoamMapBowRadius;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = FoamMap)
+	float FoamMapBowRate;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = FoamMap)
+	float FoamMapHullRadius;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = FoamMap)
+	float FoamMapDragRate;
+
 	//camera parameters
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Camera)
@@ -249,6 +318,12 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Camera)
 	float CameraTilt;
 
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Camera)
+	bool bAsyncCameraTrace;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Camera)
+	float CameraWaterClearance;
+
 	// Steering input
 	void SteerRudder(float Val);
 
@@ -285,6 +360,10 @@ public:
 	// Lens firing input
 	void SetLensFire(bool Fire);
 
+	// Where the lens beam ends and the buoy or vessel it is on, null if it isn't on one - returns false if the lens isn't firing
+	UFUNCTION(BlueprintCallable, Category = Lens)
+	bool GetLensBeamHit(AActor* &HitActor, FVector &HitLocation);
+
 	// Below get functions are for getting touch zone locations and swipe rotations
 
 	FVector GetRudderWorldLocation();
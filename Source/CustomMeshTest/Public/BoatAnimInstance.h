@@ -3,8 +3,58 @@
 #pragma once
 
 #include "Animation/AnimInstance.h"
+#include "Animation/AnimInstanceProxy.h"
+#include "BoneContainer.h"
 #include "BoatAnimInstance.generated.h"
 
+//worker thread side of the boat anim instance - turns the rudder, sails and lens natively while the oars are stowed, otherwise leaves the pose to the anim graph
+struct FBoatAnimInstanceProxy : public FAnimInstanceProxy
+{
+	FBoatAnimInstanceProxy() {}
+
+	FBoatAnimInstanceProxy(UAnimInstance* InAnimInstance)
+		: FAnimInstanceProxy(InAnimInstance)
+	{
+	}
+
+	// Copy the anim instance's inputs on the game thread before the update runs
+	virtual void PreUpdate(UAnimInstance* InAnimInstance, float DeltaSeconds) override;
+
+	// Build the pose from the reference pose and the part rotations, if native evaluation is on and the oars are stowed
+	virtual bool Evaluate(FPoseContext& Output) override;
+
+private:
+
+	// Turn a bone from its reference pose by an angle in degrees about one of its axes
+	static void TurnBone(FPoseContext &Output, FBoneReference &Bone, FVector Axis, float Degrees);
+
+	//copied inputs
+
+	bool bNativeEvaluation;
+
+	FBoneReference RudderBone;
+
+	FBoneReference SailBone;
+
+	FBoneReference JibBone;
+
+	FBoneReference LensYawBone;
+
+	FBoneReference LensPitchBone;
+
+	float RudderPos;
+
+	float SailPos;
+
+	float JibWindRot;
+
+	float LensYaw;
+
+	float LensPitch;
+
+	bool Rowing;
+};
+
 /**
  * 
  */
@@ -54,8 +104,19 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Rowing)
 	float RowSpeed;
 
+	//inputs the pose was last evaluated with, and how long they have been still
+
+	TArray<float> PosedInputs;
+
+	float PoseStillTime;
+
+	// Create the proxy the anim update and evaluation run on
+	virtual FAnimInstanceProxy* CreateAnimInstanceProxy() override;
+
 public:
 
+	UBoatAnimInstance();
+
 	// Input wind power and rotation for main sail
 	void SetWind(float Rot, float Power);
 
@@ -76,4 +137,40 @@ public:
 
 	// Input lens rotation
 	void SetLens(float Yaw, float Pitch);
+
+	// Whether the pose needs evaluating this frame - false once the inputs have been still for the settle time and the oars aren't rowing
+	bool NeedsPoseUpdate(float DeltaTime);
+
+	//native animation parameters
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = NativeAnimation)
+	bool bNativeEvaluation;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = NativeAnimation)
+	FBoneReference RudderBone;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = NativeAnimation)
+	FBoneReference SailBone;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = NativeAnimation)
+	FBoneReference JibBone;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = NativeAnimation)
+	FBoneReference LensYawBone;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = NativeAnimation)
+	FBoneReference LensPitchBone;
+
+	//still pose parameters
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = StillPoses)
+	bool bSkipStillPoses;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = StillPoses)
+	float PoseChangeTolerance;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = StillPoses)
+	float PoseSettleTime;
+
+	friend struct FBoatAnimInstanceProxy;
 };
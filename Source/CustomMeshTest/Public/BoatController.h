@@ -65,6 +65,9 @@ private:
 	// Calculate the distance swiped in a direction relative to the 3d world 
 	float SwipeAmountFromWorld(FVector2D SwipeStart, FVector2D SwipeEnd, FVector WorldLocation, FRotator WorldRotation);
 
+	// Whether a wave between the camera and a touch zone hides it, ignoring the water within the clearance of the zone so zones at the waterline can still be touched
+	bool IsHiddenByOcean(FVector ZoneLocation);
+
 protected:
 
 	// Handle all touch related input
@@ -81,6 +84,9 @@ public:
 	// Called every frame
 	virtual void Tick(float DeltaSeconds);
 
+	// Find where a screen position (e.g. a touch) looks onto the ocean surface
+	bool GetOceanLocationAtScreenPosition(FVector2D ScreenPosition, FVector &OceanLocation, float MaxDistance = 20000.f);
+
 	//view parameters
 	float ViewTurnSpeed;
 	 
@@ -119,4 +125,8 @@ public:
 	float LensTouchRadius;
 
 	float LensDoubleTouchTime;
+
+	//ocean occlusion parameters
+
+	float OceanOcclusionClearance;
 };
@@ -22,6 +22,15 @@ private:
 
 	float FoamIntervalTimer;
 
+	//game foam manager
+	class AFoamManager* FoamManager;
+
+	//game ocean significance manager, sets how often the buoy ticks and whether it spawns foam
+	class AOceanSignificanceManager* SignificanceManager;
+
+	//game ocean spatial hash, finds vessels close enough to see the buoy's foam
+	class AOceanSpatialHash* SpatialHash;
+
 protected:
 
 	//actor components
@@ -40,6 +49,9 @@ public:
 
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
+
+	// Called when the buoy is removed from play
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	
 	// Called every frame
 	virtual void Tick( float DeltaSeconds ) override;
@@ -54,5 +66,11 @@ public:
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Foam)
 	float FoamSpawnDistance;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = FoamMap)
+	float FoamMapRadius;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = FoamMap)
+	float FoamMapRate;
 	
 };
@@ -3,8 +3,44 @@
 #pragma once
 
 #include "Animation/AnimInstance.h"
+#include "Animation/AnimInstanceProxy.h"
+#include "BoneContainer.h"
 #include "BuoyAnimInstance.generated.h"
 
+//worker thread side of the buoy anim instance - turns the vane and compass bones natively, or leaves the pose to the anim graph
+struct FBuoyAnimInstanceProxy : public FAnimInstanceProxy
+{
+	FBuoyAnimInstanceProxy() {}
+
+	FBuoyAnimInstanceProxy(UAnimInstance* InAnimInstance)
+		: FAnimInstanceProxy(InAnimInstance)
+	{
+	}
+
+	// Copy the anim instance's inputs on the game thread before the update runs
+	virtual void PreUpdate(UAnimInstance* InAnimInstance, float DeltaSeconds) override;
+
+	// Build the pose from the reference pose and the part rotations, if native evaluation is on
+	virtual bool Evaluate(FPoseContext& Output) override;
+
+private:
+
+	// Turn a bone from its reference pose by an angle in degrees about one of its axes
+	static void TurnBone(FPoseContext &Output, FBoneReference &Bone, FVector Axis, float Degrees);
+
+	//copied inputs
+
+	bool bNativeEvaluation;
+
+	FBoneReference VaneBone;
+
+	FBoneReference CompassBone;
+
+	float WindRot;
+
+	float NorthRot;
+};
+
 /**
  * 
  */
@@ -27,13 +63,52 @@ protected:
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = PartRotations)
 	float NorthRot;
+
+	//part rotations the pose was last evaluated with, and how long they have been still
+
+	float PosedWindRot;
+
+	float PosedNorthRot;
+
+	float PoseStillTime;
+
+	// Create the proxy the anim update and evaluation run on
+	virtual FAnimInstanceProxy* CreateAnimInstanceProxy() override;
 	
 public:
+
+	UBuoyAnimInstance();
 	
 	// Input wind rotation
 	void SetWind(float Rot);
 
 	// Input North rotation
 	void SetNorth(float Rot);
-	
+
+	// Whether the pose needs evaluating this frame - false once the part rotations have been still for the settle time
+	bool NeedsPoseUpdate(float DeltaTime);
+
+	//native animation parameters
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = NativeAnimation)
+	bool bNativeEvaluation;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = NativeAnimation)
+	FBoneReference VaneBone;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = NativeAnimation)
+	FBoneReference CompassBone;
+
+	//still pose parameters
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = StillPoses)
+	bool bSkipStillPoses;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = StillPoses)
+	float PoseChangeTolerance;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = StillPoses)
+	float PoseSettleTime;
+
+	friend struct FBuoyAnimInstanceProxy;
 };
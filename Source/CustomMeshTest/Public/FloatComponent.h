@@ -3,9 +3,40 @@
 #pragma once
 
 #include "Components/ActorComponent.h"
+#include "FloatHull.h"
+#include "OceanSpatialHash.h"
 #include "FloatComponent.generated.h"
 
 
+//physics state of a float, advanced in fixed steps and interpolated for display
+struct FFloatState
+{
+	FVector Location;
+
+	FQuat Rotation;
+
+	FVector PositionOnOcean;
+
+	FVector Velocity;
+
+	//angular velocity about world axes, radians per second
+	FVector AVelocity;
+
+	bool IsInAir;
+
+	float CurrentCombinedDrag;
+
+	FFloatState()
+		: Location(FVector::ZeroVector)
+		, Rotation(FQuat::Identity)
+		, PositionOnOcean(FVector::ZeroVector)
+		, Velocity(FVector::ZeroVector)
+		, AVelocity(FVector::ZeroVector)
+		, IsInAir(false)
+		, CurrentCombinedDrag(0.f)
+	{ }
+};
+
 UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
 class CUSTOMMESHTEST_API UFloatComponent : public UActorComponent
 {
@@ -13,27 +44,73 @@ class CUSTOMMESHTEST_API UFloatComponent : public UActorComponent
 
 private:
 
-	//location/velocities of the float
+	//physics state after the latest step and the step before it
 
-	FVector PositionOnOcean;
+	FFloatState State;
 
-	FVector Velocity;
+	FFloatState PreviousState;
 
-	FRotator AVelocity;
+	//time not yet simulated
+	float StepAccumulator;
 
-	bool IsInAir;
+	// Advance the physics state by one step, sampling the waves at the float's location
+	void StepFloat(float StepTime, float Time);
 
-	float CurrentCombinedDrag;
+	// Move the owner to its state between the previous and latest step
+	void ApplyInterpolatedTransform(float Alpha);
+
+	//world float system stepping this float, its state is held there instead while registered
+
+	class AFloatSystem* FloatSystem;
+
+	int32 FloatSystemIndex;
+
+	// Physics state of this float, wherever it is held
+	FFloatState& GetState();
+
+	//float rides the waves instead of being simulated, set by the significance manager
+	bool bRideOnly;
 
 	//game wave manager
 	class UWaveManager* WaveManager;
 
+	//game ocean spatial hash, the owner is indexed in it wherever it floats
+	class AOceanSpatialHash* SpatialHash;
+
+	//hull clipped against the waves in hydrostatics mode, its pressure is scaled so it rests at its draft in still water
+
+	FFloatHull Hull;
+
+	float HullPressureScale;
+
+	//hull wave batch buffers when stepping by itself
+
+	TArray<FVector> HullWorldVerts;
+
+	TArray<FVector2D> HullSamplePositions;
+
+	TArray<float> HullHeights;
+
+	TArray<FVector> HullNormals;
+
+	// Build the hull from the hull mesh, or a box if there isn't one
+	void BuildHull();
+
+	// Change a state's velocities by one step of water pressure over the hull
+	void ApplyHullPressure(FFloatState &FloatState, float StepTime, const FVector* WorldVerts, const float* WaveHeights) const;
+
+	// Rotate a state by its angular velocity over one step
+	static void IntegrateRotation(FFloatState &FloatState, float StepTime);
+
 public:	
 	// Sets default values for this component's properties
 	UFloatComponent();
 
 	// Called when the game starts
 	virtual void BeginPlay() override;
+
+	// Called when the component is removed from play
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	
 	// Called every frame
 	virtual void TickComponent( float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction ) override;
@@ -63,6 +140,80 @@ public:
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Movement)
 	float Slide;
+
+	//fixed step parameters
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Stepping)
+	bool bUseFloatSystem;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Stepping)
+	bool bFixedTimestep;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Stepping, meta = (ClampMin = 1))
+	float StepRate;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Stepping, meta = (ClampMin = 1))
+	int32 MaxSubsteps;
+
+	//hull hydrostatics parameters
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Hull)
+	bool bHullHydrostatics;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Hull)
+	class UStaticMesh* HullMesh;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Hull)
+	FVector HullExtent;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Hull)
+	float HullDraft;
+
+	//spatial index parameters
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Spatial)
+	EOceanSpatialKind SpatialKind;
+
+	//contact parameters - a circle on the ocean plane, stretched into a capsule along the float's forward axis by the half length
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Contact)
+	bool bFloatContacts;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Contact)
+	float ContactRadius;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Contact)
+	float ContactHalfLength;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Contact)
+	float ContactMass;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Contact)
+	float ContactRestitution;
+
+	// Advance a physics state by one step given the waves at its location, and the wave height under each hull vert if the float has a hull
+	void IntegrateFloat(FFloatState &FloatState, float StepTime, FVector WaveDisplacement, FVector WaveNormal, const FVector* HullVerts = nullptr, const float* HullVertHeights = nullptr) const;
+
+	// Whether the float is buoyed by water pressure over its hull rather than a single point
+	bool HasHull() const;
+
+	// Add the world position of each hull vert, and its position on the ocean plane to sample the waves at, for a physics state
+	void AppendHullSamples(const FFloatState &FloatState, TArray<FVector> &WorldVerts, TArray<FVector2D> &SamplePositions) const;
+
+	// Whether the float system pushes this float apart from the floats it touches
+	bool HasContactShape() const;
+
+	// Ends of the float's contact capsule on the ocean plane for a physics state, both at its centre for a circle
+	void GetContactSegment(const FFloatState &FloatState, FVector &Start, FVector &End) const;
+
+	// Furthest the contact shape reaches from the float's centre
+	float GetContactReach() const;
+
+	// Inverse of the float's mass, and of its moment of inertia about the vertical, for contact impulses
+	void GetContactInverseMass(float &InvMass, float &InvInertia) const;
+
+	// Index of this float's state in the world float system
+	void SetFloatSystemIndex(int32 Index);
 	
 	// Input angular yaw velocity
 	void SetYawVelocity(float Val);
@@ -78,4 +229,9 @@ public:
 	FVector GetVelocity();
 
 	bool GetIsInAir();
+
+	// Let the float system ride this float on the waves instead of simulating it, however near it is
+	void SetRideOnly(bool RideOnly);
+
+	bool IsRideOnly();
 };
@@ -0,0 +1,48 @@
+// Simplified hull of a float - its triangles are clipped against the wave surface and the water pressure on the submerged parts summed into a force and torque
+
+#pragma once
+
+class CUSTOMMESHTEST_API FFloatHull
+{
+private:
+
+	//hull mesh in the float's space, triangles wound so their normals face out of the hull
+
+	TArray<FVector> Verts;
+
+	TArray<int32> Indices;
+
+	//mean squared distance of the verts from the float's origin, stands in for the hull's inertia per unit mass
+	float RadiusOfGyrationSquared;
+
+	// Wind every triangle the same way, with normals facing out of the hull
+	void OrientTriangles();
+
+	// Add the pressure force and torque on a fully submerged triangle given the depth of each of its corners
+	static void AddTrianglePressure(const FVector &A, const FVector &B, const FVector &C, float DepthA, float DepthB, float DepthC, const FVector &Centre, FVector &Force, FVector &Torque);
+
+public:
+
+	FFloatHull();
+
+	// Build a box shaped hull with the given half extents, centred on the float
+	void BuildBox(FVector Extent);
+
+	// Build the hull from the first level of a static mesh, scaled into the float's space - the mesh needs CPU access to be read in cooked builds
+	bool BuildFromStaticMesh(class UStaticMesh* Mesh, FVector Scale);
+
+	bool IsBuilt() const;
+
+	int32 GetNumVerts() const;
+
+	float GetRadiusOfGyrationSquared() const;
+
+	// Volume under flat water with the float upright and its lowest point the given depth under the surface
+	float GetDisplacedVolume(float Draft) const;
+
+	// Add the world position of each vert, and its position on the ocean plane to sample the waves at, for a float transform
+	void AppendSamples(FVector Location, FQuat Rotation, TArray<FVector> &WorldVerts, TArray<FVector2D> &SamplePositions) const;
+
+	// Sum the water pressure force and its torque about the centre over the submerged part of the hull, using the wave height at each vert - pressure is depth times area, returns false if no part is under water
+	bool ComputePressure(const FVector* WorldVerts, const float* WaveHeights, FVector Centre, FVector &Force, FVector &Torque) const;
+};
@@ -0,0 +1,183 @@
+// Steps every float in the world together - float states are kept side by side, the waves are sampled for all of them in one batch and each owner's transform is written once per frame
+
+#pragma once
+
+#include "GameFramework/Actor.h"
+#include "FloatComponent.h"
+#include "FloatSystem.generated.h"
+
+UCLASS()
+class CUSTOMMESHTEST_API AFloatSystem : public AActor
+{
+	GENERATED_BODY()
+
+private:
+
+	//float states - one entry per registered float in each array
+
+	TArray<class UFloatComponent*> Floats;
+
+	TArray<FFloatState> States;
+
+	TArray<FFloatState> PreviousStates;
+
+	//distant floats ride the waves instead of being simulated
+
+	TArray<bool> Riding;
+
+	TArray<float> RideTimers;
+
+	//floats that have just woken blend from where they were riding into their simulation
+
+	TArray<float> BlendAlphas;
+
+	TArray<FTransform> BlendFrom;
+
+	//floats being simulated this frame
+	TArray<int32> ActiveFloats;
+
+	//riding floats due an update this frame
+	TArray<int32> RideFloats;
+
+	//time not yet simulated
+	float StepAccumulator;
+
+	//wave batch buffers
+
+	TArray<FVector2D> SamplePositions;
+
+	TArray<FVector> WaveDisplacements;
+
+	TArray<FVector> WaveNormals;
+
+	//world hull verts and the wave height under each, and where each float's hull starts in them
+
+	TArray<FVector> HullWorldVerts;
+
+	TArray<FVector2D> HullSamplePositions;
+
+	TArray<float> HullHeights;
+
+	TArray<FVector> HullNormals;
+
+	TArray<int32> HullStarts;
+
+	//hull pass already warned it went over its time budget
+	bool HullPassOverBudget;
+
+	//float each owner is, to find floats from the spatial hash
+	TMap<AActor*, int32> OwnerIndices;
+
+	//pairs of floats close enough to touch during this frame's steps, the first is simulated and the second may be riding
+	TArray<FIntPoint> ContactPairs;
+
+	//contact broadphase buffer
+	TArray<AActor*> ContactNeighbours;
+
+	// Advance every float by one step, sampling the waves for all of them at once
+	void StepFloats(float StepTime, float Time);
+
+	// Move every float's owner to its state between the previous and latest step
+	void ApplyInterpolatedTransforms(float Alpha, float DeltaTime);
+
+	// Switch floats between riding and simulation by distance from the player and whether they're being seen
+	void UpdateRiding(const struct FOceanContext& Ocean);
+
+	// Place riding floats that are due an update straight onto the wave surface
+	void RideFloatsOnWaves(float DeltaTime, float Time);
+
+	// Find pairs of floats that could touch during this frame's steps by looking around each simulated float in the spatial hash
+	void FindContactPairs(float DeltaTime);
+
+	// Push touching floats apart on the ocean plane and bounce them off each other, riding floats don't move
+	void ResolveContacts();
+
+	//game wave manager
+	class UWaveManager* WaveManager;
+
+	//game ocean spatial hash, told where each float's owner has moved
+	class AOceanSpatialHash* SpatialHash;
+
+public:	
+	// Sets default values for this actor's properties
+	AFloatSystem();
+	
+	// Called every frame
+	virtual void Tick( float DeltaSeconds ) override;
+
+	// Start stepping a float with the rest, returns its index
+	int32 RegisterFloat(class UFloatComponent* Float, const FFloatState &InitialState);
+
+	// Stop stepping a float, the last float takes its index
+	void UnregisterFloat(class UFloatComponent* Float);
+
+	// Physics state of a registered float
+	FFloatState& GetFloatState(int32 Index);
+
+	int32 GetNumFloats();
+
+	// Number of floats currently riding the waves instead of being simulated
+	UFUNCTION(BlueprintCallable, Category = Riding)
+	int32 GetNumRidingFloats();
+
+	//fixed step parameters
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Stepping, meta = (ClampMin = 1))
+	float StepRate;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Stepping, meta = (ClampMin = 1))
+	int32 MaxSubsteps;
+
+	//wave riding parameters
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Riding)
+	bool bRideDistantFloats;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Riding)
+	float RideDistance;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Riding)
+	float RideHiddenDistance;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Riding)
+	float RideHiddenTime;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Riding)
+	float RideHysteresis;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Riding)
+	float RideTickInterval;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Riding)
+	float WakeBlendTime;
+
+	//parallel integration parameters
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Parallel)
+	bool bParallelIntegrate;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Parallel)
+	int32 ParallelMinFloats;
+
+	//contact parameters
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Contact)
+	bool bFloatContacts;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Contact)
+	int32 ContactIterations;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Contact)
+	float ContactCorrection;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Contact)
+	float ContactSlop;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Contact)
+	float ContactMargin;
+
+	//hull pass time budget in milliseconds, warned about once when a step goes over it
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Stepping, meta = (ClampMin = 0))
+	float HullPassBudgetMs;
+};
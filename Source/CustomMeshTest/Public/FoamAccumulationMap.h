@@ -0,0 +1,65 @@
+// Visual only - world aligned foam intensity map around a moving centre, splatted into and decayed on the CPU and uploaded as a texture for the ocean material
+
+#pragma once
+
+class CUSTOMMESHTEST_API FFoamAccumulationMap
+{
+private:
+
+	//map size
+
+	int32 Resolution;
+
+	float WorldSize;
+
+	float TexelSize;
+
+	//world texel coordinate of the first texel in the window, texels wrap around the map so moving the window only clears the strips that enter it
+	FIntPoint WindowOrigin;
+
+	bool WindowValid;
+
+	//foam intensity per texel, 0 to 1
+	TArray<float> Intensity;
+
+	//intensity packed for upload
+	TArray<uint8> UploadTexels;
+
+	// Index into the map of a world texel coordinate
+	int32 WrapIndex(int32 WorldTexel) const;
+
+	// Clear every texel in a column of world texels
+	void ClearColumn(int32 WorldTexelX);
+
+	// Clear every texel in a row of world texels
+	void ClearRow(int32 WorldTexelY);
+
+public:
+
+	FFoamAccumulationMap();
+
+	// Create an empty map of the given resolution covering the given world size
+	void Init(int32 NewResolution, float NewWorldSize);
+
+	// Move the window the map covers to be centred on a location, clearing texels that scroll in
+	void Recentre(FVector2D Centre);
+
+	// Add foam in a disc with linear falloff from its centre
+	void Splat(FVector2D Location, float Radius, float Amount);
+
+	// Scale every texel's foam by the given factor
+	void Decay(float Factor);
+
+	// Foam intensity at a world location, 0 outside the window
+	float GetIntensityAt(FVector2D Location) const;
+
+	// Pack the map into bytes ready to upload to an 8 bit texture
+	const TArray<uint8>& PackTexels();
+
+	int32 GetResolution() const;
+
+	float GetWorldSize() const;
+
+	// World centre of the window the map covers
+	FVector2D GetCentre() const;
+};
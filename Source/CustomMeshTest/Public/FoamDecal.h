@@ -21,6 +21,21 @@ private:
 	//dynamic materials
 
 	class UMaterialInstanceDynamic* DynamicFoamMat;
+
+	//pool that runs this decal's life and takes it back at the end, the decal runs its own life if none
+	class AFoamManager* Pool;
+
+	//game ocean significance manager, sets how often the decal ticks
+	class AOceanSignificanceManager* SignificanceManager;
+
+	//game ocean spatial hash, the decal is indexed in it while it is alive
+	class AOceanSpatialHash* SpatialHash;
+
+	//material params last pushed while pooled
+
+	float PushedAlpha;
+
+	float PushedScale;
 	
 public:	
 	// Sets default values for this actor's properties
@@ -28,11 +43,23 @@ public:
 
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
+
+	// Called when the decal is removed from play
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	
 	// Called every frame
 	virtual void Tick( float DeltaSeconds ) override;
 
-	//lifetime parameters
+	// Hand this decal's life over to the given pool instead of running it itself
+	void SetPool(class AFoamManager* NewPool);
+
+	// Place a pooled decal at the start of a new life
+	void ResetFoam(FVector Location, float Yaw);
+
+	// Take the pose and material params the pool worked out for this frame and move the mesh onto the waves
+	void UpdatePooledFoam(float Yaw, float Scale, float LifeAlpha);
+
+	//lifetime parameters - only used by decals placed by themselves, pooled decals' lives are run by the pool
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Life)
 	UCurveFloat*  AlphaLifeCurve;
@@ -45,4 +72,9 @@ public:
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Life)
 	float GrowRate;
+
+	//pooled material parameters - smallest change in alpha or scale that is pushed to the material
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Material)
+	float MaterialParamStep;
 };
@@ -0,0 +1,254 @@
+// Visual only - keeps every foam patch on the ocean in one place, simulating them together and drawing them all as a single merged mesh or as pooled decals
+
+#pragma once
+
+#include "GameFramework/Actor.h"
+#include "FoamAccumulationMap.h"
+#include "FoamManager.generated.h"
+
+//float curve baked into a fixed resolution table over a life, sampled without walking the curve's keys
+struct CUSTOMMESHTEST_API FFoamCurveLUT
+{
+	TArray<float> Values;
+
+	//length of life the table covers, from time 0
+	float LifeLength;
+
+	FFoamCurveLUT() : LifeLength(0.f) { }
+
+	// Sample the curve over its time range into a table of the given resolution
+	void Bake(UCurveFloat* Curve, int32 Resolution);
+
+	// Linearly interpolated curve value at a time within the life
+	float Sample(float Time) const;
+};
+
+//one merged mesh section holding every foam patch drawn at a given grid level
+struct FFoamLODSection
+{
+	int32 Stage;
+
+	TSharedPtr<const struct FOceanDecalGridTopology> GridTopology;
+
+	//patches the section has room for
+	int32 Capacity;
+
+	//patches drawn at this level this frame
+	TArray<int32> Patches;
+
+	TArray<FVector> Verts;
+
+	TArray<FVector> Normals;
+
+	TArray<FColor> Colors;
+
+	FFoamLODSection() : Stage(0), Capacity(0) { }
+};
+
+UCLASS()
+class CUSTOMMESHTEST_API AFoamManager : public AActor
+{
+	GENERATED_BODY()
+
+private:
+
+	//foam patch state - one entry per live patch in each array
+
+	TArray<FVector> FoamLocations;
+
+	TArray<float> FoamYaws;
+
+	TArray<float> FoamRotateRates;
+
+	TArray<float> FoamLives;
+
+	TArray<float> FoamGrowths;
+
+	TArray<float> FoamGrowRates;
+
+	TArray<float> FoamAlphas;
+
+	//per patch data for the foam material, alpha in A and growth in R
+	TArray<FColor> FoamColors;
+
+	//decal drawing each patch when foam isn't merged, null for merged patches
+	UPROPERTY()
+	TArray<class AFoamDecal*> FoamDecals;
+
+	//alpha life curve baked at begin play
+	FFoamCurveLUT AlphaLUT;
+
+	//merged mesh, one section per foam level
+
+	TArray<FFoamLODSection> LODSections;
+
+	TArray<int32> PatchOrder;
+
+	TArray<float> PatchDistances;
+
+	//level each patch is drawn at this frame, INDEX_NONE if it is over the vert budget
+	TArray<int32> PatchLODs;
+
+	// Pick each foam patch's level by camera distance and vert budget, nearest patches claiming the budget first
+	void PickFoamLODs();
+
+	// Advance the life of every foam patch and remove those at the end of their life
+	void UpdateFoamLife(float DeltaTime);
+
+	// Pick each foam patch's level, then update every level's mesh section
+	void UpdateFoamMesh();
+
+	// Pick each foam patch's level, then pass every pooled decal its grid, pose and material params for this frame and move it onto the waves
+	void UpdateFoamDecals();
+
+	// Move the verts of every patch drawn at one foam level onto the waves and send them to that level's mesh section
+	void UpdateLODSection(int32 LODIndex, float Time);
+
+	// Recreate the merged mesh section for one foam level with room for that level's capacity
+	void RebuildMeshSection(int32 LODIndex);
+
+	// Make room for a new foam patch by removing the oldest patch fainter than it, false if there is none
+	bool RecycleFoam(float Alpha);
+
+	// Remove a foam patch by swapping the last patch into its place
+	void RemoveFoam(int32 Index);
+
+	//game wave manager
+	class UWaveManager* WaveManager;
+
+	//foam decal actor pool - used when foam isn't merged
+
+	UPROPERTY()
+	TArray<class AFoamDecal*> FreeFoamDecals;
+
+	int32 FoamPoolSize;
+
+	int32 FoamPoolHits;
+
+	int32 FoamPoolMisses;
+
+	//pool size that next warns it has grown, doubled each time
+	int32 FoamPoolWarnSize;
+
+	// Spawn a new hidden foam decal into the pool
+	void GrowFoamPool();
+
+	// Take a foam decal from the pool, growing the pool if it is empty
+	class AFoamDecal* AcquireFoamDecal(AActor* Spawner);
+
+	//foam accumulation map
+
+	FFoamAccumulationMap FoamMap;
+
+	UPROPERTY()
+	UTexture2D* FoamMapTexture;
+
+	// Scroll the foam accumulation map with the player, decay it and upload it to its texture
+	void UpdateFoamMap(float DeltaTime);
+
+protected:
+
+	//actor components
+
+	UPROPERTY(EditAnywhere, Category = Components)
+	USceneComponent* SceneRoot;
+
+	UPROPERTY(EditAnywhere, Category = Components)
+	class UProceduralMeshComponent* FoamMesh;
+
+public:	
+	// Sets default values for this actor's properties
+	AFoamManager();
+
+	// Called when the game starts or when spawned
+	virtual void BeginPlay() override;
+	
+	// Called when the manager is removed from the world
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// Called every frame
+	virtual void Tick( float DeltaSeconds ) override;
+
+	// Add a new foam patch to the ocean
+	void SpawnFoam(FVector Location, float Alpha, float GrowRate, float RotateRate, AActor* Spawner);
+
+	int32 GetNumFoam();
+
+	// Add foam into the foam accumulation map in a disc with falloff from its centre
+	void SplatFoamMap(FVector Location, float Radius, float Amount);
+
+	// Foam accumulation map intensity at a world location, 0 outside the map
+	UFUNCTION(BlueprintCallable, Category = FoamMap)
+	float GetFoamMapIntensityAt(FVector Location);
+
+	// Pass the foam accumulation map texture and where it lies in the world to a material
+	void ApplyFoamMap(class UMaterialInstanceDynamic* Material);
+
+	// Hide a foam decal at the end of its patch's life and return it to the pool
+	void ReleaseFoamDecal(class AFoamDecal* FoamDecal);
+
+	// Foam decal pool usage so the pool can be sized per platform
+	UFUNCTION(BlueprintCallable, Category = FoamPool)
+	void GetFoamPoolStats(int32& Hits, int32& Misses, int32& Free, int32& Total);
+
+	//foam parameters - merged foam needs a foam material that fades by vertex colour A and grows by vertex colour R, off until there is one
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Foam)
+	bool bMergeFoam;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Foam)
+	float FoamScaleRange;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Life)
+	UCurveFloat*  AlphaLifeCurve;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Life)
+	int32 AlphaLUTResolution;
+
+	//foam budget and level parameters
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = FoamBudget)
+	int32 MaxFoamPatches;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = FoamBudget)
+	int32 MaxFoamVerts;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = FoamBudget)
+	int32 NumFoamLODs;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = FoamBudget)
+	int32 FoamLODStageStep;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = FoamBudget)
+	float FoamLODDistance;
+
+	//foam accumulation map parameters
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = FoamMap)
+	bool bFoamMap;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = FoamMap)
+	int32 FoamMapResolution;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = FoamMap)
+	float FoamMapWorldSize;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = FoamMap)
+	float FoamMapDecayRate;
+
+	//foam decal pool parameters
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = FoamPool)
+	int32 FoamPoolPrewarm;
+
+	//foam grid parameters
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = MeshGrid)
+	int32 GridStage;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = MeshGrid)
+	float  GridCellSize;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Material)
+	UMaterial* FoamMaterial;
+};
@@ -54,5 +54,20 @@ public:
 
 	// Find the wave's displacement and normal given a position and time
 	virtual void GetWaveDisplacementNormal(FVector2D Position, float Time, FVector &Displacement, FVector &Normal) override;
+
+	// Largest vertical displacement the wave can produce
+	virtual float GetMaxHeight() override;
+
+	// Gerstner phase is linear in position and time, so it can always be cached
+	virtual bool SupportsPhaseCache() override;
+
+	// Find the part of the wave's phase that depends only on position
+	virtual float GetSpatialPhase(FVector2D Position) override;
+
+	// Find the part of the wave's phase that depends only on time
+	virtual float GetTimePhase(float Time) override;
+
+	// Find the wave's displacement and normal given the cos and sin of its total phase
+	virtual void GetWaveDisplacementNormalFromPhase(float CosPhase, float SinPhase, FVector &Displacement, FVector &Normal) override;
 	
 };
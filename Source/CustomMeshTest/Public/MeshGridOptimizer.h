@@ -0,0 +1,42 @@
+// Build time optimizer for generated grid meshes - reorders triangles and verts so the GPU's post-transform vertex cache is reused as much as possible
+
+#pragma once
+
+class CUSTOMMESHTEST_API FMeshGridOptimizer
+{
+private:
+
+	//forsyth scoring parameters
+
+	static const int32 ForsythCacheSize = 32;
+
+	// Score a vert by its position in the simulated cache and how many unadded tris still use it
+	static float ForsythVertScore(int32 CachePosition, int32 ActiveTris);
+
+public:
+
+	// Reorder tris and verts for vertex cache reuse and log the average cache miss ratio before and after, OldToNew maps each old vert index to its new index
+	static void Optimize(TArray<int32> &Tris, int32 NumVerts, TArray<int32> &OldToNew, const TCHAR* MeshName);
+
+	// Reorder tris for vertex cache reuse (Forsyth linear-speed optimizer)
+	static void OptimizeTriangleOrder(TArray<int32> &Tris, int32 NumVerts);
+
+	// Renumber verts in order of first use by the tris, so vertex fetch follows the index buffer
+	static void ReorderVertsByFirstUse(TArray<int32> &Tris, int32 NumVerts, TArray<int32> &OldToNew);
+
+	// Average cache miss ratio (transformed verts per tri) of the tris through a FIFO vertex cache
+	static float CalculateACMR(const TArray<int32> &Tris, int32 CacheSize = 16);
+
+	// Move every element of a per vert array to its new index
+	template<typename T>
+	static void RemapVerts(TArray<T> &Verts, const TArray<int32> &OldToNew)
+	{
+		TArray<T> Remapped;
+		Remapped.SetNum(Verts.Num());
+		for (int32 i = 0; i < Verts.Num(); i++)
+		{
+			Remapped[OldToNew[i]] = Verts[i];
+		}
+		Verts = MoveTemp(Remapped);
+	}
+};
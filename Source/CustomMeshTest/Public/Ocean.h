@@ -21,9 +21,52 @@ private:
 
 	bool GridBuilt;
 
+	bool CompactStreamBuilt;
+
 	//game wave manager
 	class UWaveManager* WaveManager;
 
+	//foam map material
+
+	UPROPERTY()
+	class UMaterialInstanceDynamic* DynamicWaveMat;
+
+	class AFoamManager* FoamManager;
+
+	// Material for the ocean mesh, a dynamic instance of the wave material when it samples the foam map
+	UMaterialInterface* GetOceanMaterial();
+
+	//spatial phase caching
+
+	TArray<FVector2D> PhaseCache;
+
+	TArray<FVector2D> TimePhase;
+
+	FVector PhaseCacheLocation;
+
+	FRotator PhaseCacheRotation;
+
+	int32 PhaseCacheWaveVersion;
+
+	bool PhaseCacheValid;
+
+	bool PhaseCacheOverBudget;
+
+	//grid fitting
+
+	FIntPoint FittedViewportSize;
+
+	float FittedFOV;
+
+	// Refit and rebuild the grid if the viewport size or field of view has changed since the last fit
+	void UpdateGridFit();
+
+	// Generate grid stage count, Y scale and expansion curve that meet the pixels per triangle target with the fewest verts
+	void FitGridToView(FIntPoint ViewportSize, float FOV);
+
+	// Rebuild the spatial phase cache if the ocean has snapped since it was built, returns whether the cache can be used
+	bool UpdatePhaseCache();
+
 protected:
 
 	//actor components
@@ -34,6 +77,9 @@ protected:
 	UPROPERTY(EditAnywhere, Category = Components)
 	class UProceduralMeshComponent* OceanMesh;
 
+	UPROPERTY(EditAnywhere, Category = Components)
+	class UOceanMeshComponent* CompactOceanMesh;
+
 public:	
 	// Sets default values for this actor's properties
 	AOcean();
@@ -64,6 +110,53 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = MeshGrid)
 	float GridUVSize;
 
+	//grid fitting parameters - generate GridStage, GridYScale and GridExpansionCurve from the view instead of tuning by hand
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = GridFitting)
+	bool bAutoFitGrid;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = GridFitting)
+	float TargetPixelsPerTriangle;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = GridFitting)
+	float FitMaxDistance;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = GridFitting)
+	float FitFOVMargin;
+
+	//compact vertex stream parameters - quantized positions and packed normals instead of full procedural mesh verts
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = CompactVertexStream)
+	bool bCompactVertexStream;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = CompactVertexStream)
+	float CompactVertexMargin;
+
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Material)
 	UMaterial* WaveMaterial;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Material)
+	bool bUseFoamMap;
+
+	//lattice snapping parameters
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Snapping)
+	bool bSnapToLattice;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Snapping)
+	float LatticeSnapSize;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Snapping)
+	float LatticeSnapYaw;
+
+	//phase cache parameters - only used when snapping to lattice
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = PhaseCache)
+	bool bCachePhase;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = PhaseCache)
+	float PhaseCacheMaxMegabytes;
+
+	// Move and rotate the ocean to follow the player's view, snapping to the world aligned lattice if enabled
+	void FollowView(FVector Location, float Yaw);
 };
@@ -41,6 +41,40 @@ struct FGridVert
 	}
 };
 
+//generated decal grid - immutable once built and shared by every decal with the same grid parameters
+struct FOceanDecalGridTopology
+{
+	TArray<FVector> Verts;
+
+	TArray<int32> Tris;
+
+	TArray<FVector2D> UVs;
+};
+
+//grid parameters identifying a shared decal grid
+struct FOceanDecalGridKey
+{
+	int32 Stage;
+
+	float CellSize;
+
+	FOceanDecalGridKey(int32 StageSet, float CellSizeSet)
+	{
+		Stage = StageSet;
+		CellSize = CellSizeSet;
+	}
+
+	bool operator==(const FOceanDecalGridKey &Other) const
+	{
+		return Stage == Other.Stage && CellSize == Other.CellSize;
+	}
+
+	friend uint32 GetTypeHash(const FOceanDecalGridKey &Key)
+	{
+		return HashCombine(GetTypeHash(Key.Stage), GetTypeHash(Key.CellSize));
+	}
+};
+
 UCLASS()
 class CUSTOMMESHTEST_API AOceanDecal : public AActor
 {
@@ -48,13 +82,16 @@ class CUSTOMMESHTEST_API AOceanDecal : public AActor
 
 	//ocean grid building
 
-	TArray<FVector> GridVerts;
+	TSharedPtr<const FOceanDecalGridTopology> GridTopology;
 
-	// Create a hexagonal grid of vertices that will form the ocean decal
+	// Create the ocean decal mesh from the shared hexagonal grid for this decal's grid parameters
 	void CreateGridVerts();
 
+	// Create a hexagonal grid of vertices that will form the ocean decal
+	static TSharedPtr<const FOceanDecalGridTopology> BuildGridTopology(int32 Stage, float CellSize);
+
 	// Find the point that will form an equilatiral triangle with 2 given points
-	FVector2D TriangulateEdge(FVector V1, FVector V2);
+	static FVector2D TriangulateEdge(FVector V1, FVector V2, float CellSize);
 
 	bool GridBuilt;
 
@@ -81,6 +118,12 @@ public:
 	// Called every frame
 	virtual void Tick( float DeltaSeconds ) override;
 
+	// Move the decal mesh's verts onto the waves for this frame
+	void UpdateWaveMesh();
+
+	// Switch the decal mesh to another shared grid, e.g. a coarser one when the decal is far away - keeps the decal's materials
+	void SetGridTopology(TSharedPtr<const FOceanDecalGridTopology> NewGridTopology);
+
 	//ocean grid parameters
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = MeshGrid)
@@ -91,5 +134,7 @@ public:
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Material)
 	UMaterial* WaveMaterial;
-	
+
+	// Find the shared grid for the given grid parameters, building it the first time they are used
+	static TSharedPtr<const FOceanDecalGridTopology> GetGridTopology(int32 Stage, float CellSize);
 };
@@ -0,0 +1,78 @@
+// Visual only - mesh component for the ocean grid with a compact vertex stream: quantized positions and packed normals are the only data sent every frame
+
+#pragma once
+
+#include "Components/MeshComponent.h"
+#include "OceanMeshComponent.generated.h"
+
+//vertex in the per frame stream of the ocean mesh (12 bytes)
+struct FOceanCompactVertex
+{
+	//position relative to the component, quantized to the component's quantization extent (W is always 1)
+	int16 Position[4];
+
+	FPackedNormal Normal;
+
+	// Quantize a position and normal into this vertex - normal must be normalized
+	FORCEINLINE void Set(const FVector &VertPosition, const FVector &VertNormal, float InvExtent)
+	{
+		Position[0] = (int16)FMath::Clamp(FMath::RoundToInt(VertPosition.X * InvExtent * 32767.f), -32767, 32767);
+		Position[1] = (int16)FMath::Clamp(FMath::RoundToInt(VertPosition.Y * InvExtent * 32767.f), -32767, 32767);
+		Position[2] = (int16)FMath::Clamp(FMath::RoundToInt(VertPosition.Z * InvExtent * 32767.f), -32767, 32767);
+		Position[3] = 32767;
+		Normal = FPackedNormal(VertNormal);
+	}
+};
+
+UCLASS(ClassGroup = Rendering)
+class CUSTOMMESHTEST_API UOceanMeshComponent : public UMeshComponent
+{
+	GENERATED_BODY()
+
+private:
+
+	//static grid data - only sent to the render thread when the mesh is created
+
+	TArray<int32> Tris;
+
+	TArray<FVector2D> UVs;
+
+	//per frame vertex stream, written directly by the ocean
+
+	TArray<FOceanCompactVertex> Verts;
+
+	float QuantizationExtent;
+
+	//component overrides
+
+	virtual FPrimitiveSceneProxy* CreateSceneProxy() override;
+
+	virtual int32 GetNumMaterials() const override;
+
+	virtual FBoxSphereBounds CalcBounds(const FTransform &LocalToWorld) const override;
+
+public:
+
+	// Sets default values for this component's properties
+	UOceanMeshComponent();
+
+	// Create the mesh from static grid data - QuantizationExtent is the largest distance from the component any vert can reach
+	void CreateMesh(const TArray<int32> &GridTris, const TArray<FVector2D> &GridUVs, float Extent);
+
+	// Per frame vertex stream to write this frame's verts into, then send with UpdateMesh
+	TArray<FOceanCompactVertex>& GetVertsForWrite();
+
+	// 1 / quantization extent, for FOceanCompactVertex::Set
+	float GetInvQuantizationExtent();
+
+	// Send the per frame vertex stream to the render thread
+	void UpdateMesh();
+
+	//static data access for the scene proxy
+
+	const TArray<int32>& GetTris() const;
+
+	const TArray<FVector2D>& GetUVs() const;
+
+	const TArray<FOceanCompactVertex>& GetVerts() const;
+};
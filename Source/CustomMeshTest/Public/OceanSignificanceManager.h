@@ -0,0 +1,121 @@
+// Scores every ocean actor by how much it matters to the view and sets how often it ticks and animates, whether it spawns foam and how its float is simulated by tier
+
+#pragma once
+
+#include "GameFramework/Actor.h"
+#include "OceanSignificanceManager.generated.h"
+
+UCLASS()
+class CUSTOMMESHTEST_API AOceanSignificanceManager : public AActor
+{
+	GENERATED_BODY()
+
+private:
+
+	//managed actors - one entry per registered actor in each array
+
+	TArray<AActor*> Actors;
+
+	TArray<int32> Tiers;
+
+	TArray<float> Radii;
+
+	//where each managed actor is in the arrays
+	TMap<AActor*, int32> ActorIndices;
+
+	//actors are scored a slice at a time, so every actor is scored once per score interval
+	int32 NextScored;
+
+	float ScoreAccumulator;
+
+	//actors in each tier
+	TArray<int32> TierCounts;
+
+	//ticks skipped by lowered tick rates since the last report, and the running average cost of a managed tick
+
+	float SkippedTicks;
+
+	float AverageTickCost;
+
+	float ReportTimer;
+
+	float SkippedTicksPerSecond;
+
+	// Score an actor by its size on screen and whether it has been seen lately, and move it to the matching tier
+	void ScoreActor(int32 Index, FVector ViewLocation, float Time);
+
+	// Set an actor's tick and anim rates and float fidelity for its tier
+	void ApplyTier(int32 Index);
+
+	// Tier for a score, highest scores in tier 0
+	int32 GetTierForScore(float Score) const;
+
+public:
+	// Sets default values for this actor's properties
+	AOceanSignificanceManager();
+
+	// Called when the game starts or when spawned
+	virtual void BeginPlay() override;
+
+	// Called every frame
+	virtual void Tick( float DeltaSeconds ) override;
+
+	// Start managing an actor, in the top tier until it is first scored
+	void RegisterActor(AActor* Actor);
+
+	// Stop managing an actor, the last actor takes its index
+	void UnregisterActor(AActor* Actor);
+
+	// Tier of a managed actor, 0 if it isn't managed
+	int32 GetTier(const AActor* Actor) const;
+
+	// Whether a managed actor's tier lets it spawn foam
+	bool IsFoamAllowed(const AActor* Actor) const;
+
+	// Add the measured length of one managed actor tick to the running average
+	void RecordTickCost(float Seconds);
+
+	// Number of managed actors in a tier
+	UFUNCTION(BlueprintCallable, Category = Significance)
+	int32 GetTierCount(int32 Tier);
+
+	// Estimated game thread milliseconds saved per second by lowered tick rates
+	UFUNCTION(BlueprintCallable, Category = Significance)
+	float GetMillisecondsSavedPerSecond();
+
+	//scoring parameters
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Scoring)
+	float ScoreInterval;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Scoring)
+	float RecentRenderTime;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Scoring)
+	float HiddenScoreScale;
+
+	//tier parameters - screen size each tier but the last needs, and per tier intervals
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Tiers)
+	TArray<float> TierScreenSizes;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Tiers)
+	TArray<float> TierTickIntervals;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Tiers)
+	TArray<float> TierAnimIntervals;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Tiers)
+	int32 FoamMaxTier;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Tiers)
+	int32 RideMinTier;
+
+	//reporting parameters
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Reporting)
+	float ReportInterval;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Reporting)
+	bool bLogReports;
+};
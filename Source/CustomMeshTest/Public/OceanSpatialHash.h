@@ -0,0 +1,96 @@
+// Uniform grid over the ocean plane indexing every float, foam patch and vessel by location, so nearby actors can be found without looking at all of them
+
+#pragma once
+
+#include "GameFramework/Actor.h"
+#include "OceanSpatialHash.generated.h"
+
+//enum for kinds of indexed actor, queries take a mask of kinds built with AOceanSpatialHash::GetKindMask - foam is foam decals, merged foam patches aren't actors and aren't indexed
+UENUM(BlueprintType)
+enum class EOceanSpatialKind : uint8 { OSK_Float, OSK_Foam, OSK_Vessel };
+
+UCLASS()
+class CUSTOMMESHTEST_API AOceanSpatialHash : public AActor
+{
+	GENERATED_BODY()
+
+private:
+
+	//indexed actors - one entry per registered actor in each array
+
+	TArray<AActor*> Actors;
+
+	TArray<FVector> Locations;
+
+	TArray<EOceanSpatialKind> Kinds;
+
+	TArray<FIntPoint> EntryCells;
+
+	//where each indexed actor is in the arrays
+	TMap<AActor*, int32> ActorIndices;
+
+	//entries in each occupied cell, cells are removed when they empty
+	TMap<FIntPoint, TArray<int32>> Cells;
+
+	//query buffers
+
+	TArray<TPair<float, int32>> Candidates;
+
+	TSet<FIntPoint> VisitedCells;
+
+	// Cell containing a location
+	FIntPoint GetCell(FVector Location) const;
+
+	// Add an entry to a cell
+	void AddToCell(FIntPoint Cell, int32 Index);
+
+	// Take an entry out of a cell, removing the cell if it empties
+	void RemoveFromCell(FIntPoint Cell, int32 Index);
+
+	// Add every entry of a kind in the mask within a radius of a point in a cell to the candidates, keyed by distance squared
+	void GatherCell(const TArray<int32> &Entries, FVector Centre, float RadiusSquared, int32 KindMask);
+
+	// Copy the candidates into an actor array, nearest first
+	int32 SortCandidates(int32 MaxCount, TArray<AActor*> &OutActors);
+
+public:
+	// Sets default values for this actor's properties
+	AOceanSpatialHash();
+
+	// Start indexing an actor at its location, or update its kind and location if it is already indexed
+	void RegisterActor(AActor* Actor, EOceanSpatialKind Kind);
+
+	// Stop indexing an actor, the last actor takes its index
+	void UnregisterActor(AActor* Actor);
+
+	// Update an indexed actor's location, only touching the cells if it has moved into another one
+	void MoveActor(AActor* Actor, FVector Location);
+
+	// Mask matching a single kind of actor
+	UFUNCTION(BlueprintPure, Category = SpatialQuery)
+	static int32 GetKindMask(EOceanSpatialKind Kind);
+
+	// Find every actor of a kind in the mask within a radius of a point, nearest first
+	UFUNCTION(BlueprintCallable, Category = SpatialQuery)
+	int32 QueryRadius(FVector Centre, float Radius, int32 KindMask, TArray<AActor*> &OutActors);
+
+	// Find up to a number of the nearest actors of a kind in the mask, no further than a radius from a point, nearest first
+	UFUNCTION(BlueprintCallable, Category = SpatialQuery)
+	int32 QueryNearest(FVector Centre, int32 Count, float MaxRadius, int32 KindMask, TArray<AActor*> &OutActors);
+
+	// Find every actor of a kind in the mask within a radius of a line segment, in order along the segment
+	UFUNCTION(BlueprintCallable, Category = SpatialQuery)
+	int32 QuerySegment(FVector Start, FVector End, float Radius, int32 KindMask, TArray<AActor*> &OutActors);
+
+	// Whether any actor of a kind in the mask is within a radius of a point
+	UFUNCTION(BlueprintCallable, Category = SpatialQuery)
+	bool AnyInRadius(FVector Centre, float Radius, int32 KindMask);
+
+	UFUNCTION(BlueprintCallable, Category = SpatialQuery)
+	int32 GetNumActors();
+
+	//grid parameters - cells should be around the size of the usual query radius, fixed once actors are indexed
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Grid)
+	float CellSize;
+};
@@ -0,0 +1,139 @@
+// Visual only - spray thrown up along a spline by a vessel, simulated natively and drawn as one buffer of camera facing sprites that splash into the waves
+
+#pragma once
+
+#include "ProceduralMeshComponent.h"
+#include "SprayEmitterComponent.generated.h"
+
+
+UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
+class CUSTOMMESHTEST_API USprayEmitterComponent : public UProceduralMeshComponent
+{
+	GENERATED_BODY()
+
+private:
+
+	//spline sampled at equal distances along it, in the owner's space
+
+	TArray<FVector> ArcPositions;
+
+	TArray<FVector> ArcNormals;
+
+	//particle state - one entry per live particle in each array, padded to whole vectors
+
+	TArray<float> PosX;
+
+	TArray<float> PosY;
+
+	TArray<float> PosZ;
+
+	TArray<float> VelX;
+
+	TArray<float> VelY;
+
+	TArray<float> VelZ;
+
+	TArray<float> Ages;
+
+	int32 NumParticles;
+
+	int32 Capacity;
+
+	//wave queries for falling particles
+
+	TArray<FVector2D> QueryPositions;
+
+	TArray<int32> QueryParticles;
+
+	TArray<FVector> Displacements;
+
+	TArray<FVector> WaveNormals;
+
+	TArray<bool> Dead;
+
+	//sprite buffer
+
+	TArray<FVector> Verts;
+
+	TArray<FVector> Normals;
+
+	TArray<FColor> Colors;
+
+	int32 NumDrawn;
+
+	bool SpritesBuilt;
+
+	// Create the sprite buffer with room for every particle
+	void BuildSprites();
+
+	// Move every particle and age it, 4 particles at a time
+	void IntegrateParticles(float DeltaTime);
+
+	// Kill particles at the end of their life or that have fallen into the waves, splashing foam where they land
+	void KillParticles(float Time);
+
+	// Remove a particle by swapping the last particle into its place
+	void RemoveParticle(int32 Index);
+
+	// Build a camera facing quad for every live particle
+	void UpdateSprites();
+
+	//game wave and foam managers
+
+	class UWaveManager* WaveManager;
+
+	class AFoamManager* FoamManager;
+
+	//ticking and drawn, off when the vessel uses the spray particle system
+	bool SprayEnabled;
+
+public:	
+	// Sets default values for this component's properties
+	USprayEmitterComponent();
+
+	// Called when the game starts
+	virtual void BeginPlay() override;
+	
+	// Called every frame
+	virtual void TickComponent( float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction ) override;
+
+	// Sample a spline into the table particles are emitted from
+	void BuildArcTable(class USplineComponent* Spline);
+
+	// Emit particles at random points along the spline, thrown out from it and upwards
+	void Emit(int32 Count, float MinSpeed, float MaxSpeed);
+
+	int32 GetNumParticles();
+
+	// Turn the spray on or off - off stops it ticking and hides it, on builds the sprite buffer the first time
+	void SetSprayEnabled(bool Enabled);
+
+	bool IsSprayEnabled();
+
+	//spray parameters
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Spray)
+	int32 MaxParticles;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Spray)
+	int32 ArcTableSize;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Spray)
+	float Lifetime;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Spray)
+	float Gravity;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Spray)
+	float SpriteSize;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Spray)
+	float SplashRadius;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Spray)
+	float SplashAmount;
+
+	//spray material, fades each sprite by vertex colour A
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Material)
+	UMaterial* SprayMaterial;
+};
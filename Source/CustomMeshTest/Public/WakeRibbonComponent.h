@@ -0,0 +1,113 @@
+// Visual only - wake left behind a vessel, a ring buffer of cross sections drawn as one ribbon mesh that follows the waves and fades with age
+
+#pragma once
+
+#include "ProceduralMeshComponent.h"
+#include "WakeRibbonComponent.generated.h"
+
+
+UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
+class CUSTOMMESHTEST_API UWakeRibbonComponent : public UProceduralMeshComponent
+{
+	GENERATED_BODY()
+
+private:
+
+	//ring buffer of wake cross sections, the oldest is overwritten by the newest
+
+	TArray<FVector2D> SectionCentres;
+
+	TArray<FVector2D> SectionRights;
+
+	TArray<float> SectionTimes;
+
+	//distance along the wake, for texture coordinates that stay put as the wake grows
+	TArray<float> SectionDistances;
+
+	//gap sections break the ribbon where the vessel stopped emitting
+	TArray<bool> SectionGaps;
+
+	int32 NewestSection;
+
+	int32 NumSections;
+
+	float WakeDistance;
+
+	bool WasEmitting;
+
+	bool RibbonBuilt;
+
+	//per frame mesh buffers
+
+	TArray<FVector2D> QueryPositions;
+
+	TArray<FVector> Displacements;
+
+	TArray<FVector> WaveNormals;
+
+	TArray<FVector> Verts;
+
+	TArray<FVector> Normals;
+
+	TArray<FVector2D> UV0;
+
+	TArray<FColor> Colors;
+
+	// Create the ribbon mesh section with room for every cross section in the ring
+	void BuildRibbon();
+
+	// Add a cross section as the newest in the ring
+	void AddCrossSection(FVector2D Centre, FVector2D Right, bool Gap, float Time);
+
+	//game wave manager
+	class UWaveManager* WaveManager;
+
+	//ticking and drawn, off when the vessel has no wake
+	bool WakeEnabled;
+
+public:	
+	// Sets default values for this component's properties
+	UWakeRibbonComponent();
+
+	// Called when the game starts
+	virtual void BeginPlay() override;
+	
+	// Called every frame
+	virtual void TickComponent( float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction ) override;
+
+	// Turn the whole ribbon on or off - off stops it ticking and hides it, on starts a fresh wake and builds the ribbon the first time
+	void SetWakeEnabled(bool Enabled);
+
+	bool IsWakeEnabled();
+
+	//whether the vessel is currently leaving a wake
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Wake)
+	bool bEmitting;
+
+	//wake parameters
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Wake)
+	int32 RingSize;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Wake)
+	float SectionSpacing;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Wake)
+	FVector WakeOffset;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Wake)
+	float StartHalfWidth;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Wake)
+	float SpreadRate;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Wake)
+	float Lifetime;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Wake)
+	float UVLength;
+
+	//wake material, fades by vertex colour A
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Material)
+	UMaterial* WakeMaterial;
+};
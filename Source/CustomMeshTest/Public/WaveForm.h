@@ -26,6 +26,21 @@ public:
 	// Find the wave's displacement and normal given a position and time
 	virtual void GetWaveDisplacementNormal(FVector2D Position, float Time, FVector &Displacement, FVector &Normal);
 
+	// Largest vertical displacement the wave can produce
+	virtual float GetMaxHeight();
+
+	// Whether the wave's phase can be split into a part depending only on position and a part depending only on time
+	virtual bool SupportsPhaseCache();
+
+	// Find the part of the wave's phase that depends only on position
+	virtual float GetSpatialPhase(FVector2D Position);
+
+	// Find the part of the wave's phase that depends only on time
+	virtual float GetTimePhase(float Time);
+
+	// Find the wave's displacement and normal given the cos and sin of its total phase
+	virtual void GetWaveDisplacementNormalFromPhase(float CosPhase, float SinPhase, FVector &Displacement, FVector &Normal);
+
 	// Called after the wave is created
 	virtual void Init(class UWaveManager* Manager);
 
@@ -19,7 +19,13 @@ private:
 	UPROPERTY()
 	TArray<class UWaveForm*> WaveForms;
 
+	//incremented whenever the wave forms change, so cached wave data can be invalidated
+	int32 WaveVersion;
+
 public:
+
+	// Sets default values
+	UWaveManager();
 	
 	// Add a wave form to be used
 	UFUNCTION(BlueprintCallable, Category = Waves)
@@ -31,4 +37,58 @@ public:
 
 	// Find the overall displacement and normal of all waves given a position and time
 	void GetWaveDisplacementNormal(FVector2D Position, float Time, FVector &Displacement, FVector &Normal);
+
+	//surface queries
+
+	// Find the height and normal of the wave surface directly above/below a world position, undoing the horizontal displacement of the waves
+	void GetWaveHeightNormal(FVector2D Position, float Time, float &Height, FVector &Normal);
+
+	// Find the height of the wave surface directly above/below a world position
+	UFUNCTION(BlueprintCallable, Category = Waves)
+	float GetWaveHeight(FVector2D Position, float Time);
+
+	// Largest height the combined waves can reach
+	float GetMaxWaveHeight();
+
+	// Find the displacement and normal of all waves at many positions at once, one wave form at a time over every position
+	void GetWaveDisplacementNormalBatch(const TArray<FVector2D> &Positions, float Time, TArray<FVector> &Displacements, TArray<FVector> &Normals);
+
+	// Find the height and normal of the wave surface directly above/below many world positions at once
+	void GetWaveHeightNormalBatch(const TArray<FVector2D> &Positions, float Time, TArray<float> &Heights, TArray<FVector> &Normals);
+
+	// Find where a line first crosses the wave surface, by marching along it and refining the crossing
+	UFUNCTION(BlueprintCallable, Category = Waves)
+	bool LineTraceWaves(FVector Start, FVector End, float Time, FVector &HitLocation, FVector &HitNormal);
+
+	//surface query parameters
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = SurfaceQueries)
+	int32 HeightIterations;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = SurfaceQueries)
+	float TraceStepSize;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = SurfaceQueries)
+	int32 TraceMaxSteps;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = SurfaceQueries)
+	int32 TraceRefineIterations;
+
+	//phase caching
+
+	int32 GetNumWaveForms();
+
+	int32 GetWaveVersion();
+
+	// Check every wave form can split its phase into a spatial part and a time part
+	bool CanCachePhase();
+
+	// Find cos and sin of every wave's spatial phase at each position - table is position major (Position * NumWaveForms + Wave)
+	bool CacheSpatialPhase(const TArray<FVector2D> &Positions, TArray<FVector2D> &PhaseTable);
+
+	// Find cos and sin of every wave's time phase
+	void GetTimePhase(float Time, TArray<FVector2D> &TimePhase);
+
+	// Find the overall displacement and normal of all waves from the cached spatial phase of one position, rotated by the time phase
+	void GetWaveDisplacementNormalCached(const FVector2D* SpatialPhase, const TArray<FVector2D> &TimePhase, FVector &Displacement, FVector &Normal);
 };